@@ -0,0 +1,173 @@
+#include "culling.hpp"
+
+#if defined(__AVX__) || defined(__SSE__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+namespace graphics::renderer {
+
+#if defined(__AVX__)
+constexpr size_t k_batch_size = 8;
+#elif defined(__SSE__) || defined(_M_X64)
+constexpr size_t k_batch_size = 4;
+#else
+constexpr size_t k_batch_size = 1;
+#endif
+
+/* Bounding spheres of one batch, as structure of arrays. */
+struct sphere_batch {
+  alignas(32) float x[k_batch_size];
+  alignas(32) float y[k_batch_size];
+  alignas(32) float z[k_batch_size];
+  alignas(32) float r[k_batch_size];
+};
+
+frustum make_frustum(const glm::mat4& view_projection) {
+  // rows of the matrix; glm is column major
+  glm::vec4 rows[4];
+  for (int i = 0; i < 4; ++i) {
+    rows[i] = glm::vec4(view_projection[0][i], view_projection[1][i],
+                        view_projection[2][i], view_projection[3][i]);
+  }
+
+  frustum f;
+  f.planes[0] = rows[3] + rows[0];  // left
+  f.planes[1] = rows[3] - rows[0];  // right
+  f.planes[2] = rows[3] + rows[1];  // bottom
+  f.planes[3] = rows[3] - rows[1];  // top
+  f.planes[4] = rows[3] + rows[2];  // near
+  f.planes[5] = rows[3] - rows[2];  // far
+
+  for (auto& plane : f.planes) {
+    plane = plane / glm::length(glm::vec3(plane));
+  }
+  return f;
+}
+
+/* Returns a bit mask with bit i set if sphere i of the batch intersects the
+ * frustum. */
+static unsigned visibility_mask(const frustum& f, const sphere_batch& b) {
+#if defined(__AVX__)
+  const __m256 x = _mm256_load_ps(b.x);
+  const __m256 y = _mm256_load_ps(b.y);
+  const __m256 z = _mm256_load_ps(b.z);
+  const __m256 r = _mm256_load_ps(b.r);
+
+  __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+  for (const auto& plane : f.planes) {
+    __m256 d = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)),
+                             _mm256_mul_ps(y, _mm256_set1_ps(plane.y)));
+    d = _mm256_add_ps(d, _mm256_mul_ps(z, _mm256_set1_ps(plane.z)));
+    d = _mm256_add_ps(d, _mm256_add_ps(r, _mm256_set1_ps(plane.w)));
+    inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+  }
+  return static_cast<unsigned>(_mm256_movemask_ps(inside));
+#elif defined(__SSE__) || defined(_M_X64)
+  const __m128 x = _mm_load_ps(b.x);
+  const __m128 y = _mm_load_ps(b.y);
+  const __m128 z = _mm_load_ps(b.z);
+  const __m128 r = _mm_load_ps(b.r);
+
+  __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+  for (const auto& plane : f.planes) {
+    __m128 d = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)),
+                          _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+    d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+    d = _mm_add_ps(d, _mm_add_ps(r, _mm_set1_ps(plane.w)));
+    inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_setzero_ps()));
+  }
+  return static_cast<unsigned>(_mm_movemask_ps(inside));
+#else
+  for (const auto& plane : f.planes) {
+    if (plane.x * b.x[0] + plane.y * b.y[0] + plane.z * b.z[0] + plane.w < -b.r[0]) {
+      return 0;
+    }
+  }
+  return 1;
+#endif
+}
+
+/* Culls instances in batches, gathering each batch's bounding spheres with
+ * sphere_of(instance, batch, lane). The last batch is padded with spheres that
+ * are never visible. */
+template <class T, class SphereFn>
+static size_t cull_batched(const frustum& f,
+                           const T* instances,
+                           size_t n,
+                           T* out,
+                           SphereFn sphere_of) {
+  size_t n_visible = 0;
+  sphere_batch batch;
+
+  for (size_t first = 0; first < n; first += k_batch_size) {
+    const size_t count = std::min(k_batch_size, n - first);
+
+    for (size_t lane = 0; lane < count; ++lane) {
+      sphere_of(instances[first + lane], batch, lane);
+    }
+    for (size_t lane = count; lane < k_batch_size; ++lane) {
+      batch.x[lane] = batch.y[lane] = batch.z[lane] = 0.f;
+      batch.r[lane] = -INFINITY;
+    }
+
+    unsigned mask = visibility_mask(f, batch);
+    for (size_t lane = 0; mask != 0; ++lane, mask >>= 1) {
+      if (mask & 1u) {
+        out[n_visible++] = instances[first + lane];
+      }
+    }
+  }
+
+  return n_visible;
+}
+
+size_t frustum_culler::cull(const frustum& f,
+                            const utilities::compact_instance* instances,
+                            size_t n,
+                            float bounding_radius,
+                            utilities::compact_instance* out) {
+  auto sphere_of = [bounding_radius](const utilities::compact_instance& instance,
+                                     sphere_batch& batch, size_t lane) {
+    batch.x[lane] = instance.position.x;
+    batch.y[lane] = instance.position.y;
+    batch.z[lane] = instance.position.z;
+    batch.r[lane] = bounding_radius * std::abs(instance.scale);
+  };
+
+  const size_t n_visible = cull_batched(f, instances, n, out, sphere_of);
+  m_tested += n;
+  m_visible += n_visible;
+  return n_visible;
+}
+
+size_t frustum_culler::cull(const frustum& f,
+                            const glm::mat4* matrices,
+                            size_t n,
+                            float bounding_radius,
+                            glm::mat4* out) {
+  auto sphere_of = [bounding_radius](const glm::mat4& m, sphere_batch& batch,
+                                     size_t lane) {
+    const float scale = std::max({glm::length(glm::vec3(m[0])),
+                                  glm::length(glm::vec3(m[1])),
+                                  glm::length(glm::vec3(m[2]))});
+    batch.x[lane] = m[3].x;
+    batch.y[lane] = m[3].y;
+    batch.z[lane] = m[3].z;
+    batch.r[lane] = bounding_radius * scale;
+  };
+
+  const size_t n_visible = cull_batched(f, matrices, n, out, sphere_of);
+  m_tested += n;
+  m_visible += n_visible;
+  return n_visible;
+}
+
+void frustum_culler::reset_counters() {
+  m_tested = 0;
+  m_visible = 0;
+}
+
+}  // namespace graphics::renderer
@@ -0,0 +1,82 @@
+#ifndef CULLING_HPP
+#define CULLING_HPP
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <utils/instance_buffer.hpp>
+#include <utils/instance_format.hpp>
+
+namespace graphics::renderer {
+
+/* Planes of a view frustum, in world space. A point p is inside a plane if
+ * dot(plane.xyz, p) + plane.w >= 0. The plane normals have unit length, so
+ * the value is the signed distance to the plane. */
+struct frustum {
+  std::array<glm::vec4, 6> planes;
+};
+
+/* Extracts the frustum planes from a projection * view matrix. */
+frustum make_frustum(const glm::mat4& view_projection);
+
+/* Culls instances against a view frustum by testing their bounding spheres
+ * against the six planes, several instances at a time with SSE, or AVX when
+ * compiled with it. The visible instances are compacted into the output, which
+ * is intended to be a mapped region of the instance buffer. */
+class frustum_culler {
+ public:
+  /* Copies the instances whose bounding sphere intersects the frustum to out
+   * and returns how many were copied. The sphere is centered at the instance
+   * position and has radius bounding_radius times the instance scale. out must
+   * have room for n instances. */
+  size_t cull(const frustum& f,
+              const utilities::compact_instance* instances,
+              size_t n,
+              float bounding_radius,
+              utilities::compact_instance* out);
+
+  /* Same as above for model matrices. The sphere is centered at the
+   * translation and scaled by the longest basis vector. */
+  size_t cull(const frustum& f,
+              const glm::mat4* matrices,
+              size_t n,
+              float bounding_radius,
+              glm::mat4* out);
+
+  /* Culls the instances straight into the next region of the instance buffer
+   * and returns the number of visible instances to draw from it. */
+  template <class T, class Allocator>
+  size_t cull(const frustum& f,
+              const std::vector<T, Allocator>& instances,
+              float bounding_radius,
+              utilities::instance_buffer& buffer) {
+    auto out = static_cast<T*>(buffer.map_region(instances.size()));
+    if (out == nullptr) {
+      return 0;
+    }
+
+    const size_t n_visible =
+        cull(f, instances.data(), instances.size(), bounding_radius, out);
+    buffer.unmap_region();
+    return n_visible;
+  }
+
+  /* Number of instances tested since the last reset. */
+  size_t tested() const { return m_tested; }
+
+  /* Number of instances found visible since the last reset. */
+  size_t visible() const { return m_visible; }
+
+  void reset_counters();
+
+ private:
+  size_t m_tested = 0;
+  size_t m_visible = 0;
+};
+
+}  // namespace graphics::renderer
+
+#endif  // CULLING_HPP
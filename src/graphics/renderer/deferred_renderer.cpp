@@ -0,0 +1,257 @@
+#include "deferred_renderer.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <string>
+
+#include <shader/frame_uniforms.hpp>
+#include <shader/light_clusters.hpp>
+#include <shader/material_table.hpp>
+#include <shader/phong_shader.hpp>
+
+namespace graphics::renderer {
+
+// texture units of the G-buffer in the lighting pass
+constexpr GLuint k_normal_shininess_unit = 0;
+constexpr GLuint k_albedo_unit = 1;
+constexpr GLuint k_depth_unit = 2;
+
+const std::string geometry_frag_src = R"(
+
+#version 420
+
+// data from vertex shader
+in vec3 o_normal;
+in vec3 o_toCamera;
+in vec2 o_texcoords;
+in vec3 o_worldPos;
+flat in uint o_material;
+
+// G-buffer
+layout(location = 0) out vec4 o_normalShininess;
+layout(location = 1) out vec4 o_albedo;
+
+void main(void)
+{
+   vec4 material = u_materials[o_material].diffuse_shininess;
+
+   o_normalShininess = vec4(normalize(o_normal), material.a);
+   o_albedo = vec4(material.rgb, 1.0);
+}
+
+)";
+
+const std::string lighting_vert_src = R"(
+
+#version 420
+
+// one triangle covering the screen, from the vertex index alone
+void main(void)
+{
+   vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+   gl_Position = vec4(2.0 * corner - 1.0, 0.0, 1.0);
+}
+
+)";
+
+const std::string lighting_frag_src = R"(
+
+#version 420
+
+layout(binding = NORMAL_SHININESS_UNIT) uniform sampler2D u_normalShininess;
+layout(binding = ALBEDO_UNIT) uniform sampler2D u_albedo;
+layout(binding = DEPTH_UNIT) uniform sampler2D u_depth;
+
+// reconstruct world space positions from depth
+uniform mat4 u_invProjMat;
+uniform mat4 u_invViewMat;
+
+// color for framebuffer
+out vec4 resultingColor;
+
+void main(void)
+{
+   ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+   // keep the background's clear color
+   float depth = texelFetch(u_depth, pixel, 0).r;
+   if (depth == 1.0) {
+      discard;
+   }
+
+   vec4 normalShininess = texelFetch(u_normalShininess, pixel, 0);
+   diffuseColor = texelFetch(u_albedo, pixel, 0).rgb;
+   matShininess = normalShininess.a;
+
+   // the depth range is [0, 1]
+   vec2 ndc = 2.0 * gl_FragCoord.xy / vec2(textureSize(u_depth, 0)) - 1.0;
+   vec4 viewPos = u_invProjMat * vec4(ndc, 2.0 * depth - 1.0, 1.0);
+   vec3 worldPos = (u_invViewMat * vec4(viewPos.xyz / viewPos.w, 1.0)).xyz;
+
+   vec3 N = normalize(normalShininess.xyz);
+   vec3 V = normalize(u_cameraPosition - worldPos);
+
+   resultingColor = vec4(shade(N, V, worldPos, gl_FragCoord.xy), 1.0);
+}
+
+)";
+
+deferred_renderer::deferred_renderer(utilities::instance_format format,
+                                     bool clustered_lighting) {
+  // the geometry pass reads instances like the forward shader
+  std::string vert_defines;
+  if (format == utilities::instance_format::compact) {
+    vert_defines += "#define COMPACT_INSTANCES\n";
+  }
+  vert_defines += shader::frame_uniforms_src;
+
+  const std::string geometry_vert =
+      shader::with_defines(shader::phong_vert_src, vert_defines);
+  const std::string geometry_frag =
+      shader::with_defines(geometry_frag_src, shader::material_table_src);
+  m_geometry =
+      shader::compile_program_async(geometry_vert.c_str(), geometry_frag.c_str());
+
+  // the cluster declarations enable an extension and have to come first, the
+  // lighting functions follow all declarations they use
+  std::string lighting_defines =
+      "#define NORMAL_SHININESS_UNIT " + std::to_string(k_normal_shininess_unit) +
+      "\n#define ALBEDO_UNIT " + std::to_string(k_albedo_unit) +
+      "\n#define DEPTH_UNIT " + std::to_string(k_depth_unit) + "\n" +
+      shader::frame_uniforms_src;
+  if (clustered_lighting) {
+    lighting_defines =
+        shader::light_clusters_src + "#define CLUSTERED_LIGHTING\n" + lighting_defines;
+  }
+
+  const std::string lighting_frag = shader::with_defines(
+      lighting_frag_src, lighting_defines + shader::phong_lighting_src);
+  m_lighting =
+      shader::compile_program_async(lighting_vert_src.c_str(), lighting_frag.c_str());
+
+  glGenFramebuffers(1, &m_framebuffer);
+  glGenVertexArrays(1, &m_empty_vertex_array);
+}
+
+deferred_renderer::~deferred_renderer() {
+  glDeleteFramebuffers(1, &m_framebuffer);
+  glDeleteTextures(1, &m_normal_shininess);
+  glDeleteTextures(1, &m_albedo);
+  glDeleteTextures(1, &m_depth);
+  glDeleteVertexArrays(1, &m_empty_vertex_array);
+  glDeleteProgram(m_geometry.program);
+  glDeleteProgram(m_lighting.program);
+}
+
+bool deferred_renderer::ready() {
+  shader::poll_program(m_geometry);
+  shader::poll_program(m_lighting);
+  return initialize();
+}
+
+bool deferred_renderer::wait() {
+  shader::finish_program(m_geometry);
+  shader::finish_program(m_lighting);
+  return initialize();
+}
+
+bool deferred_renderer::initialize() {
+  if (m_initialized) {
+    return true;
+  }
+  if (m_geometry.status != shader::program_status::linked ||
+      m_lighting.status != shader::program_status::linked) {
+    return false;
+  }
+
+  u_inv_proj_mat = glGetUniformLocation(m_lighting.program, "u_invProjMat");
+  u_inv_view_mat = glGetUniformLocation(m_lighting.program, "u_invViewMat");
+  m_initialized = true;
+  return true;
+}
+
+static GLuint make_texture(GLenum internal_format, GLsizei width, GLsizei height) {
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, width, height);
+
+  // read with texelFetch only
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  return texture;
+}
+
+void deferred_renderer::resize(GLsizei width, GLsizei height) {
+  // immutable textures cannot be resized, so they are replaced
+  glDeleteTextures(1, &m_normal_shininess);
+  glDeleteTextures(1, &m_albedo);
+  glDeleteTextures(1, &m_depth);
+
+  m_normal_shininess = make_texture(GL_RGBA16F, width, height);
+  m_albedo = make_texture(GL_RGBA8, width, height);
+  m_depth = make_texture(GL_DEPTH_COMPONENT24, width, height);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         m_normal_shininess, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D,
+                         m_albedo, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth,
+                         0);
+
+  const GLenum draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  glDrawBuffers(2, draw_buffers);
+
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    std::cout << "Error: incomplete G-buffer, status 0x" << std::hex << status
+              << std::dec << "\n";
+  }
+
+  m_width = width;
+  m_height = height;
+}
+
+void deferred_renderer::begin_geometry(GLsizei width, GLsizei height) {
+  if (width != m_width || height != m_height) {
+    resize(width, height);
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glViewport(0, 0, width, height);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClearDepth(1.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void deferred_renderer::shade(GLuint framebuffer,
+                              const glm::mat4& view,
+                              const glm::mat4& projection) {
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  glUseProgram(m_lighting.program);
+  glUniformMatrix4fv(u_inv_proj_mat, 1, GL_FALSE,
+                     glm::value_ptr(glm::inverse(projection)));
+  glUniformMatrix4fv(u_inv_view_mat, 1, GL_FALSE, glm::value_ptr(glm::inverse(view)));
+
+  glActiveTexture(GL_TEXTURE0 + k_normal_shininess_unit);
+  glBindTexture(GL_TEXTURE_2D, m_normal_shininess);
+  glActiveTexture(GL_TEXTURE0 + k_albedo_unit);
+  glBindTexture(GL_TEXTURE_2D, m_albedo);
+  glActiveTexture(GL_TEXTURE0 + k_depth_unit);
+  glBindTexture(GL_TEXTURE_2D, m_depth);
+  glActiveTexture(GL_TEXTURE0);
+
+  // every pixel is shaded exactly once
+  glDisable(GL_DEPTH_TEST);
+  glBindVertexArray(m_empty_vertex_array);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glEnable(GL_DEPTH_TEST);
+}
+
+}  // namespace graphics::renderer
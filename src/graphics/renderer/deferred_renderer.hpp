@@ -0,0 +1,84 @@
+#ifndef DEFERRED_RENDERER_HPP
+#define DEFERRED_RENDERER_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <shader/shader.hpp>
+#include <utils/instance_format.hpp>
+
+namespace graphics::renderer {
+
+/* Deferred shading, as an alternative to drawing with shader::phong_shader.
+ * The geometry pass draws the instances into a G-buffer of world space
+ * normals, shininess, diffuse colors and depth without any lighting. The
+ * lighting pass then shades every covered pixel once with the same Blinn-Phong
+ * model as the forward shader, so overdraw does not multiply the lighting
+ * cost. With clustered lighting, each pixel only shades the lights of its
+ * cluster from shader::light_clusters, which makes the pass a tiled one.
+ *
+ *   deferred.begin_geometry(width, height);
+ *   // draw items with deferred.geometry_program()
+ *   deferred.shade(target, view_matrix, projection_matrix);
+ *
+ * The programs are compiled asynchronously; nothing may be drawn before ready
+ * returns true. */
+class deferred_renderer {
+ public:
+  explicit deferred_renderer(
+      utilities::instance_format format = utilities::instance_format::matrix,
+      bool clustered_lighting = false);
+
+  ~deferred_renderer();
+
+  deferred_renderer(const deferred_renderer&) = delete;
+  deferred_renderer& operator=(const deferred_renderer&) = delete;
+
+  /* Polls the compilation of both programs without blocking. */
+  bool ready();
+
+  /* Waits for the compilation of both programs and returns whether both
+   * linked. */
+  bool wait();
+
+  /* Program for the draw items of the geometry pass. It reads the same vertex
+   * attributes and instances as shader::phong_shader. */
+  GLuint geometry_program() const { return m_geometry.program; }
+
+  /* Binds the G-buffer, resizing it to the given size if needed, sets the
+   * viewport and clears it. */
+  void begin_geometry(GLsizei width, GLsizei height);
+
+  /* Shades the G-buffer into framebuffer, which it clears first. Depth
+   * testing is left enabled and framebuffer is left bound. */
+  void shade(GLuint framebuffer, const glm::mat4& view, const glm::mat4& projection);
+
+ private:
+  shader::async_program m_geometry;
+  shader::async_program m_lighting;
+
+  GLint u_inv_proj_mat = -1;
+  GLint u_inv_view_mat = -1;
+  bool m_initialized = false;
+
+  GLuint m_framebuffer = 0;
+  GLuint m_normal_shininess = 0;
+  GLuint m_albedo = 0;
+  GLuint m_depth = 0;
+  GLsizei m_width = 0;
+  GLsizei m_height = 0;
+
+  // the fullscreen triangle has no attributes, but core profiles need a
+  // vertex array to draw
+  GLuint m_empty_vertex_array = 0;
+
+  void resize(GLsizei width, GLsizei height);
+
+  /* Gets the uniform locations the first time it is called after both
+   * programs linked, and returns whether they have. */
+  bool initialize();
+};
+
+}  // namespace graphics::renderer
+
+#endif  // DEFERRED_RENDERER_HPP
@@ -0,0 +1,61 @@
+#include "depth_prepass.hpp"
+
+#include <string>
+
+#include <shader/frame_uniforms.hpp>
+#include <shader/phong_shader.hpp>
+
+namespace graphics::renderer {
+
+const std::string depth_frag_src = R"(
+
+#version 420
+
+// depth only
+void main(void)
+{
+}
+
+)";
+
+depth_prepass::depth_prepass(utilities::instance_format format) {
+  std::string defines;
+  if (format == utilities::instance_format::compact) {
+    defines += "#define COMPACT_INSTANCES\n";
+  }
+  defines += shader::frame_uniforms_src;
+
+  const std::string vert = shader::with_defines(shader::phong_vert_src, defines);
+  m_program = shader::compile_program_async(vert.c_str(), depth_frag_src.c_str());
+}
+
+depth_prepass::~depth_prepass() {
+  glDeleteProgram(m_program.program);
+}
+
+bool depth_prepass::ready() {
+  return shader::poll_program(m_program) == shader::program_status::linked;
+}
+
+bool depth_prepass::wait() {
+  return shader::finish_program(m_program) == shader::program_status::linked;
+}
+
+void depth_prepass::begin() {
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  glDepthMask(GL_TRUE);
+  glDepthFunc(GL_LEQUAL);
+}
+
+void depth_prepass::begin_lit_pass() {
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  glDepthMask(GL_FALSE);
+  glDepthFunc(GL_EQUAL);
+}
+
+void depth_prepass::end() {
+  glDepthMask(GL_TRUE);
+  glDepthFunc(GL_LEQUAL);
+}
+
+}  // namespace graphics::renderer
@@ -0,0 +1,57 @@
+#ifndef DEPTH_PREPASS_HPP
+#define DEPTH_PREPASS_HPP
+
+#include <glad/glad.h>
+
+#include <shader/shader.hpp>
+#include <utils/instance_format.hpp>
+
+namespace graphics::renderer {
+
+/* Depth-only pass before the lit pass, so that the lit pass shades each pixel
+ * once instead of once per overlapping fragment. The pre-pass draws the same
+ * items with program(), which shares the phong vertex shader and has an empty
+ * fragment shader, with color writes off. The lit pass then only passes
+ * fragments with GL_EQUAL depths and does not write depth.
+ *
+ *   prepass.begin();
+ *   // draw items with prepass.program()
+ *   prepass.begin_lit_pass();
+ *   // draw the same items with the lit program
+ *   prepass.end();
+ */
+class depth_prepass {
+ public:
+  explicit depth_prepass(
+      utilities::instance_format format = utilities::instance_format::matrix);
+
+  ~depth_prepass();
+
+  depth_prepass(const depth_prepass&) = delete;
+  depth_prepass& operator=(const depth_prepass&) = delete;
+
+  /* Polls the compilation of the program without blocking. */
+  bool ready();
+
+  /* Waits for the compilation and returns whether the program linked. */
+  bool wait();
+
+  GLuint program() const { return m_program.program; }
+
+  /* Turns color writes off. */
+  void begin();
+
+  /* Turns color writes on and depth writes off, and passes only fragments at
+   * the depth written by the pre-pass. */
+  void begin_lit_pass();
+
+  /* Restores depth writes and the GL_LEQUAL depth test. */
+  void end();
+
+ private:
+  shader::async_program m_program;
+};
+
+}  // namespace graphics::renderer
+
+#endif  // DEPTH_PREPASS_HPP
@@ -0,0 +1,183 @@
+#include "gpu_culling.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <string>
+
+#include <shader/shader.hpp>
+
+namespace graphics::renderer {
+
+const std::string cull_src = R"(
+
+#version 430
+
+layout(local_size_x = 64) in;
+
+// instances as INSTANCE_VEC4S vec4s each, see utilities::instance_format
+layout(std430, binding = 0) readonly buffer all_instances {
+   vec4 i_instances[];
+};
+
+layout(std430, binding = 1) writeonly buffer visible_instances {
+   vec4 o_instances[];
+};
+
+// DrawElementsIndirectCommand or DrawArraysIndirectCommand; both keep the
+// instance count in their second element
+layout(std430, binding = 2) buffer draw_command {
+   uint o_command[5];
+};
+
+uniform vec4 u_planes[6];
+uniform uint u_numInstances;
+uniform uint u_firstInstance;
+uniform float u_boundingRadius;
+
+void main(void)
+{
+   uint index = gl_GlobalInvocationID.x;
+   if (index >= u_numInstances) {
+      return;
+   }
+
+   uint source = (u_firstInstance + index) * INSTANCE_VEC4S;
+
+#ifdef COMPACT_INSTANCES
+   vec3 center = i_instances[source].xyz;
+   float radius = u_boundingRadius * abs(i_instances[source].w);
+#else
+   vec3 center = i_instances[source + 3].xyz;
+   float scale = max(length(i_instances[source].xyz),
+                     max(length(i_instances[source + 1].xyz),
+                         length(i_instances[source + 2].xyz)));
+   float radius = u_boundingRadius * scale;
+#endif
+
+   for (int i = 0; i < 6; ++i) {
+      if (dot(u_planes[i].xyz, center) + u_planes[i].w < -radius) {
+         return;
+      }
+   }
+
+   uint destination = atomicAdd(o_command[1], 1u) * INSTANCE_VEC4S;
+   for (uint i = 0u; i < INSTANCE_VEC4S; ++i) {
+      o_instances[destination + i] = i_instances[source + i];
+   }
+}
+
+)";
+
+constexpr GLuint k_work_group_size = 64;
+
+// initial number of instances; the buffers grow as needed
+constexpr size_t k_initial_instances = 1024;
+
+gpu_culler::gpu_culler(utilities::mesh_data& mesh, utilities::instance_format format)
+    : m_mesh(mesh),
+      m_instances(k_initial_instances, utilities::instance_size(format)) {
+  std::string defines =
+      "#define INSTANCE_VEC4S " +
+      std::to_string(utilities::instance_size(format) / sizeof(glm::vec4)) + "u\n";
+  if (format == utilities::instance_format::compact) {
+    defines += "#define COMPACT_INSTANCES\n";
+  }
+
+  const std::string comp = shader::with_defines(cull_src, defines);
+  m_program = shader::compile_compute_program(comp.c_str());
+
+  u_planes = glGetUniformLocation(m_program, "u_planes[0]");
+  u_num_instances = glGetUniformLocation(m_program, "u_numInstances");
+  u_first_instance = glGetUniformLocation(m_program, "u_firstInstance");
+  u_bounding_radius = glGetUniformLocation(m_program, "u_boundingRadius");
+
+  glGenBuffers(1, &m_visible_instances);
+  glGenBuffers(1, &m_draw_command);
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_draw_command);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, 5 * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+
+  // the vertex array reads the compacted instances from now on
+  const GLuint location = 3;
+  mesh.matrix_buffer.detach(mesh.vertex_array_object);
+  utilities::specify_instance_attributes(mesh.vertex_array_object, location,
+                                         m_visible_instances,
+                                         utilities::instance_size(format));
+}
+
+gpu_culler::~gpu_culler() {
+  glDeleteBuffers(1, &m_visible_instances);
+  glDeleteBuffers(1, &m_draw_command);
+  glDeleteProgram(m_program);
+}
+
+bool gpu_culler::is_supported() {
+  return GLAD_GL_VERSION_4_3;
+}
+
+void gpu_culler::dispatch(const frustum& f, size_t n, float bounding_radius) {
+  // respecifying the storage keeps the buffer name, and with it the vertex
+  // array's attribute bindings, valid
+  if (n > m_visible_capacity || m_visible_capacity == 0) {
+    m_visible_capacity = std::max(n, m_instances.capacity());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visible_instances);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+                 m_visible_capacity * m_instances.instance_size(), NULL,
+                 GL_DYNAMIC_COPY);
+  }
+
+  // count, instance count, first index/vertex, base vertex/instance, base
+  // instance; the shader increments the instance count
+  const GLuint command[5] = {static_cast<GLuint>(m_mesh.count), 0, 0, 0, 0};
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_draw_command);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(command), command);
+
+  glUseProgram(m_program);
+  glUniform4fv(u_planes, 6, glm::value_ptr(f.planes[0]));
+  glUniform1ui(u_num_instances, n);
+  glUniform1ui(u_first_instance, m_instances.base_instance());
+  glUniform1f(u_bounding_radius, bounding_radius);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_instances.buffer());
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_visible_instances);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_draw_command);
+
+  glDispatchCompute((n + k_work_group_size - 1) / k_work_group_size, 1, 1);
+
+  // the draw reads the command and the instances written by the shader
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void gpu_culler::draw() {
+  glBindVertexArray(m_mesh.vertex_array_object);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_draw_command);
+
+  if (m_mesh.indexed) {
+    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+  } else {
+    glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+  }
+
+  fence();
+}
+
+draw_item gpu_culler::make_draw_item(GLuint program, GLuint material, float depth) const {
+  draw_item item;
+  item.program = program;
+  item.vertex_array = m_mesh.vertex_array_object;
+  item.material = material;
+  item.depth = depth;
+  item.count = m_mesh.count;
+  item.indexed = m_mesh.indexed;
+  item.instance_count = 0;
+  item.base_instance = 0;
+  item.indirect_buffer = m_draw_command;
+  return item;
+}
+
+void gpu_culler::fence() {
+  // the CPU may overwrite the uploaded instances once the shader has read them
+  m_instances.fence_region();
+}
+
+}  // namespace graphics::renderer
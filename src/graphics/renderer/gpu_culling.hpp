@@ -0,0 +1,88 @@
+#ifndef GPU_CULLING_HPP
+#define GPU_CULLING_HPP
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <renderer/culling.hpp>
+#include <renderer/renderer.hpp>
+#include <utils/cube_mesh.hpp>
+#include <utils/instance_buffer.hpp>
+#include <utils/instance_format.hpp>
+
+namespace graphics::renderer {
+
+/* Culls a mesh's instances on the GPU. All instances are streamed into a
+ * shader storage buffer, a compute shader tests their bounding spheres against
+ * the frustum and appends the visible ones to a second buffer while counting
+ * them into an indirect draw command, and the mesh is drawn with
+ * glDraw*Indirect. The CPU never reads back which instances are visible.
+ *
+ * Requires OpenGL 4.3; check is_supported before constructing. */
+class gpu_culler {
+ public:
+  /* Redirects the instance attributes of the mesh's vertex array to the
+   * culled instances. The mesh must outlive the culler and must not be drawn
+   * with its own instance buffer afterwards. */
+  gpu_culler(utilities::mesh_data& mesh, utilities::instance_format format);
+
+  ~gpu_culler();
+
+  gpu_culler(const gpu_culler&) = delete;
+  gpu_culler& operator=(const gpu_culler&) = delete;
+
+  static bool is_supported();
+
+  /* Uploads the instances and dispatches the culling shader for them. */
+  template <class T, class Allocator>
+  void cull(const frustum& f,
+            const std::vector<T, Allocator>& instances,
+            float bounding_radius) {
+    auto data = static_cast<T*>(m_instances.map_region(instances.size()));
+    if (data == nullptr) {
+      return;
+    }
+
+    std::copy(instances.begin(), instances.end(), data);
+    m_instances.unmap_region();
+
+    dispatch(f, instances.size(), bounding_radius);
+  }
+
+  /* Draws the visible instances with the indirect command written by the last
+   * cull, then fences the uploaded instances. */
+  void draw();
+
+  /* Indirect draw item for the visible instances, for drawing through a
+   * draw_queue. fence must be called after the queue is flushed. */
+  draw_item make_draw_item(GLuint program, GLuint material, float depth) const;
+
+  /* Places a fence after the draw calls that read the uploaded instances. */
+  void fence();
+
+ private:
+  const utilities::mesh_data& m_mesh;
+
+  // all instances, written by the CPU every frame
+  utilities::instance_buffer m_instances;
+
+  // visible instances and the indirect draw command, written by the GPU
+  GLuint m_visible_instances = 0;
+  size_t m_visible_capacity = 0;
+  GLuint m_draw_command = 0;
+
+  GLuint m_program = 0;
+  GLint u_planes;
+  GLint u_num_instances;
+  GLint u_first_instance;
+  GLint u_bounding_radius;
+
+  void dispatch(const frustum& f, size_t n, float bounding_radius);
+};
+
+}  // namespace graphics::renderer
+
+#endif  // GPU_CULLING_HPP
@@ -0,0 +1,122 @@
+#include "gpu_profiler.hpp"
+
+#include <iostream>
+
+namespace graphics::renderer {
+
+gpu_profiler::gpu_profiler(size_t window_size) : m_window_size(window_size) {}
+
+gpu_profiler::~gpu_profiler() {
+  for (auto& frame : m_frames) {
+    glDeleteQueries(frame.queries.size(), frame.queries.data());
+  }
+}
+
+void gpu_profiler::begin_frame() {
+  m_frame = (m_frame + 1) % k_frames_in_flight;
+
+  // this slot was last used k_frames_in_flight frames ago
+  collect(m_frames[m_frame], false);
+
+  begin("frame");
+}
+
+void gpu_profiler::end_frame() {
+  // close scopes left open, including the frame itself
+  while (!m_open.empty()) {
+    end();
+  }
+}
+
+void gpu_profiler::begin(const std::string& name) {
+  auto [it, inserted] = m_scope_indices.try_emplace(name, m_names.size());
+  if (inserted) {
+    m_names.push_back(name);
+    m_windows.emplace_back(m_window_size);
+  }
+
+  auto& frame = m_frames[m_frame];
+  m_open.push_back(frame.intervals.size());
+  frame.intervals.push_back({it->second, timestamp()});
+}
+
+void gpu_profiler::end() {
+  if (m_open.empty()) {
+    std::cout << "Error: gpu_profiler::end without begin\n";
+    return;
+  }
+
+  auto& frame = m_frames[m_frame];
+  frame.intervals[m_open.back()].end_query = timestamp();
+  m_open.pop_back();
+}
+
+void gpu_profiler::flush() {
+  for (size_t i = 1; i <= k_frames_in_flight; ++i) {
+    collect(m_frames[(m_frame + i) % k_frames_in_flight], true);
+  }
+}
+
+utilities::timing_stats gpu_profiler::stats(const std::string& name) const {
+  const auto it = m_scope_indices.find(name);
+  if (it == m_scope_indices.end()) {
+    return {};
+  }
+
+  return m_windows[it->second].stats();
+}
+
+void gpu_profiler::print() const {
+  for (size_t i = 0; i < m_names.size(); ++i) {
+    const auto s = m_windows[i].stats();
+    std::cout << "GPU " << m_names[i] << ": mean " << s.mean << " ms, p50 " << s.p50
+              << " ms, p95 " << s.p95 << " ms, p99 " << s.p99 << " ms, max " << s.max
+              << " ms over " << s.samples << " frames\n";
+  }
+
+  if (m_dropped > 0) {
+    std::cout << "GPU results dropped: " << m_dropped << "\n";
+  }
+}
+
+size_t gpu_profiler::timestamp() {
+  auto& frame = m_frames[m_frame];
+  if (frame.used == frame.queries.size()) {
+    GLuint query;
+    glGenQueries(1, &query);
+    frame.queries.push_back(query);
+  }
+
+  const size_t index = frame.used++;
+  glQueryCounter(frame.queries[index], GL_TIMESTAMP);
+  return index;
+}
+
+void gpu_profiler::collect(frame_queries& frame, bool wait) {
+  if (frame.intervals.empty()) {
+    return;
+  }
+
+  // queries complete in order, so the last one tells whether all are done
+  GLint available = GL_TRUE;
+  if (!wait) {
+    glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE,
+                       &available);
+  }
+
+  if (available == GL_FALSE) {
+    m_dropped += frame.intervals.size();
+  } else {
+    for (const auto& i : frame.intervals) {
+      GLuint64 begin, end;
+      glGetQueryObjectui64v(frame.queries[i.begin_query], GL_QUERY_RESULT, &begin);
+      glGetQueryObjectui64v(frame.queries[i.end_query], GL_QUERY_RESULT, &end);
+      m_windows[i.scope].add((end - begin) * 1e-6);
+    }
+  }
+
+  frame.intervals.clear();
+  frame.used = 0;
+}
+
+}  // namespace graphics::renderer
@@ -0,0 +1,97 @@
+#ifndef GPU_PROFILER_HPP
+#define GPU_PROFILER_HPP
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/timing_window.hpp>
+
+namespace graphics::renderer {
+
+/* Measures the GPU time of named scopes with GL_TIMESTAMP queries. The queries
+ * of a frame are read k_frames_in_flight frames later, when the GPU has long
+ * finished them, so reading never stalls the pipeline; results that are still
+ * not available then are dropped rather than waited for. Scopes may nest, and
+ * every frame is also measured as a whole under the name "frame".
+ *
+ *   profiler.begin_frame();
+ *   profiler.begin("draw");
+ *   ...
+ *   profiler.end();
+ *   profiler.end_frame();
+ */
+class gpu_profiler {
+ public:
+  static constexpr size_t k_frames_in_flight = 4;
+
+  /* Statistics are kept over the last window_size frames of every scope. */
+  explicit gpu_profiler(size_t window_size = 120);
+
+  ~gpu_profiler();
+
+  gpu_profiler(const gpu_profiler&) = delete;
+  gpu_profiler& operator=(const gpu_profiler&) = delete;
+
+  /* Collects the results of the frame k_frames_in_flight frames ago and starts
+   * measuring a new frame. */
+  void begin_frame();
+
+  void end_frame();
+
+  void begin(const std::string& name);
+
+  /* Ends the innermost scope. */
+  void end();
+
+  /* Reads the results of all frames in flight, waiting for the GPU. For the
+   * end of a run, when no frame follows. */
+  void flush();
+
+  /* Names of the measured scopes, in the order they were first begun. */
+  const std::vector<std::string>& scopes() const { return m_names; }
+
+  utilities::timing_stats stats(const std::string& name) const;
+
+  /* Number of scope results dropped because the GPU was still behind. */
+  size_t dropped() const { return m_dropped; }
+
+  void print() const;
+
+ private:
+  struct interval {
+    size_t scope;
+    size_t begin_query;
+    size_t end_query = 0;
+  };
+
+  // queries issued during one frame
+  struct frame_queries {
+    std::vector<GLuint> queries;
+    size_t used = 0;
+    std::vector<interval> intervals;
+  };
+
+  std::array<frame_queries, k_frames_in_flight> m_frames;
+  size_t m_frame = 0;
+
+  std::vector<std::string> m_names;
+  std::unordered_map<std::string, size_t> m_scope_indices;
+  std::vector<utilities::timing_window> m_windows;
+  size_t m_window_size;
+
+  // intervals of the current frame that have not ended yet
+  std::vector<size_t> m_open;
+  size_t m_dropped = 0;
+
+  size_t timestamp();
+  void collect(frame_queries& frame, bool wait);
+};
+
+}  // namespace graphics::renderer
+
+#endif  // GPU_PROFILER_HPP
@@ -0,0 +1,57 @@
+#include "lod.hpp"
+
+#include <iostream>
+
+namespace graphics::renderer {
+
+lod_selector::lod_selector(std::vector<float> distances)
+    : m_counts(distances.size() + 1), m_offsets(distances.size() + 1) {
+  std::sort(distances.begin(), distances.end());
+
+  if (m_counts.size() > 256) {
+    std::cout << "Error: lod_selector supports at most 256 levels\n";
+    distances.resize(255);
+    m_counts.resize(256);
+    m_offsets.resize(256);
+  }
+
+  for (float d : distances) {
+    m_squared_distances.push_back(d * d);
+  }
+}
+
+uint8_t lod_selector::level_of(const glm::vec3& position,
+                               const glm::vec3& camera_position) const {
+  const glm::vec3 offset = position - camera_position;
+  const float squared_distance = glm::dot(offset, offset);
+
+  // a few levels at most, a linear search beats a binary one
+  uint8_t level = 0;
+  while (level < m_squared_distances.size() &&
+         squared_distance > m_squared_distances[level]) {
+    ++level;
+  }
+  return level;
+}
+
+void lod_selector::submit(draw_queue& queue,
+                          const utilities::mesh_data& mesh,
+                          const std::vector<utilities::submesh>& levels,
+                          GLuint program,
+                          GLuint material) const {
+  const size_t n_levels = std::min(levels.size(), m_counts.size());
+
+  for (size_t level = 0; level < n_levels; ++level) {
+    if (m_counts[level] == 0) {
+      continue;
+    }
+
+    const float depth = level / static_cast<float>(m_counts.size());
+    draw_item item = make_draw_item(mesh, levels[level], program, material, depth,
+                                    static_cast<GLsizei>(m_counts[level]));
+    item.base_instance += m_offsets[level];
+    queue.submit(item);
+  }
+}
+
+}  // namespace graphics::renderer
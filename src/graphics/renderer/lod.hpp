@@ -0,0 +1,102 @@
+#ifndef LOD_HPP
+#define LOD_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <renderer/culling.hpp>
+#include <renderer/renderer.hpp>
+#include <utils/cube_mesh.hpp>
+#include <utils/frame_arena.hpp>
+#include <utils/instance_buffer.hpp>
+#include <utils/instance_format.hpp>
+
+namespace graphics::renderer {
+
+/* Selects the level of detail of every visible instance of a mesh by its
+ * distance to the camera. The culled instances are bucketed level by level
+ * into one region of the mesh's instance buffer, and every non-empty level is
+ * drawn as its own instanced draw of its submesh, so distant instances cost
+ * only a few triangles. */
+class lod_selector {
+ public:
+  /* Level i is used up to distances[i] from the camera and the last level
+   * beyond the last distance, so there is one more level than distances. At
+   * most 256 levels. */
+  explicit lod_selector(std::vector<float> distances);
+
+  /* Culls the instances against the frustum and writes the visible ones to
+   * the next region of buffer, ordered by level. Scratch memory comes from the
+   * arena. Returns the number of visible instances. */
+  template <class T, class Allocator>
+  size_t cull(frustum_culler& culler,
+              const frustum& f,
+              const std::vector<T, Allocator>& instances,
+              float bounding_radius,
+              const glm::vec3& camera_position,
+              utilities::instance_buffer& buffer,
+              utilities::frame_arena& arena) {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+
+    T* visible = arena.allocate_array<T>(instances.size());
+    const size_t n_visible =
+        culler.cull(f, instances.data(), instances.size(), bounding_radius, visible);
+
+    auto levels = arena.allocate_array<uint8_t>(n_visible);
+    for (size_t i = 0; i < n_visible; ++i) {
+      levels[i] = level_of(utilities::instance_position(visible[i]), camera_position);
+      ++m_counts[levels[i]];
+    }
+
+    auto out = static_cast<T*>(buffer.map_region(n_visible));
+    if (out == nullptr) {
+      std::fill(m_counts.begin(), m_counts.end(), 0);
+      return 0;
+    }
+
+    // counting sort by level
+    auto next = arena.allocate_array<size_t>(m_counts.size());
+    size_t offset = 0;
+    for (size_t level = 0; level < m_counts.size(); ++level) {
+      m_offsets[level] = next[level] = offset;
+      offset += m_counts[level];
+    }
+
+    for (size_t i = 0; i < n_visible; ++i) {
+      out[next[levels[i]]++] = visible[i];
+    }
+    buffer.unmap_region();
+
+    return n_visible;
+  }
+
+  /* Submits one draw item per non-empty level of the last cull. levels[i] is
+   * the submesh of level i in mesh, whose instance buffer was culled into.
+   * Nearer levels get smaller depths, so they are drawn first. */
+  void submit(draw_queue& queue,
+              const utilities::mesh_data& mesh,
+              const std::vector<utilities::submesh>& levels,
+              GLuint program,
+              GLuint material) const;
+
+  size_t num_levels() const { return m_counts.size(); }
+
+  /* Number of instances of the level in the last cull. */
+  size_t count(size_t level) const { return m_counts[level]; }
+
+ private:
+  std::vector<float> m_squared_distances;
+  std::vector<size_t> m_counts;
+  std::vector<size_t> m_offsets;
+
+  uint8_t level_of(const glm::vec3& position, const glm::vec3& camera_position) const;
+};
+
+}  // namespace graphics::renderer
+
+#endif  // LOD_HPP
@@ -0,0 +1,78 @@
+#include "offscreen_target.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace graphics::renderer {
+
+offscreen_target::offscreen_target(GLsizei width, GLsizei height)
+    : m_width(width), m_height(height) {
+  glGenRenderbuffers(1, &m_color);
+  glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  glGenRenderbuffers(1, &m_depth);
+  glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &m_framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                            m_color);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+                            m_depth);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+offscreen_target::~offscreen_target() {
+  glDeleteFramebuffers(1, &m_framebuffer);
+  glDeleteRenderbuffers(1, &m_color);
+  glDeleteRenderbuffers(1, &m_depth);
+}
+
+void offscreen_target::bind() {
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+}
+
+bool offscreen_target::is_complete() const {
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    std::cout << "Error: incomplete offscreen framebuffer, status 0x" << std::hex
+              << status << std::dec << "\n";
+    return false;
+  }
+
+  return true;
+}
+
+bool offscreen_target::write_ppm(const std::string& path) const {
+  const size_t row_size = 3 * static_cast<size_t>(m_width);
+  std::vector<uint8_t> pixels(row_size * m_height);
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    std::cout << "Error: cannot write " << path << "\n";
+    return false;
+  }
+
+  file << "P6\n" << m_width << " " << m_height << "\n255\n";
+
+  // OpenGL's first row is the bottom one
+  for (GLsizei row = m_height; row-- > 0;) {
+    file.write(reinterpret_cast<const char*>(pixels.data() + row * row_size), row_size);
+  }
+
+  return static_cast<bool>(file);
+}
+
+}  // namespace graphics::renderer
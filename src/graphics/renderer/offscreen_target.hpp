@@ -0,0 +1,47 @@
+#ifndef OFFSCREEN_TARGET_HPP
+#define OFFSCREEN_TARGET_HPP
+
+#include <glad/glad.h>
+
+#include <string>
+
+namespace graphics::renderer {
+
+/* Framebuffer object with an RGBA8 color and a 24-bit depth renderbuffer, for
+ * rendering without a window. */
+class offscreen_target {
+ public:
+  offscreen_target(GLsizei width, GLsizei height);
+
+  ~offscreen_target();
+
+  offscreen_target(const offscreen_target&) = delete;
+  offscreen_target& operator=(const offscreen_target&) = delete;
+
+  /* Binds the framebuffer for drawing and reading. */
+  void bind();
+
+  /* Returns false and prints the status if the framebuffer is incomplete. */
+  bool is_complete() const;
+
+  /* Reads back the color buffer and writes it as a binary PPM image, top row
+   * first. Stalls until the GPU has finished rendering into the target. */
+  bool write_ppm(const std::string& path) const;
+
+  GLsizei width() const { return m_width; }
+  GLsizei height() const { return m_height; }
+
+  GLuint framebuffer() const { return m_framebuffer; }
+
+ private:
+  GLsizei m_width;
+  GLsizei m_height;
+
+  GLuint m_framebuffer = 0;
+  GLuint m_color = 0;
+  GLuint m_depth = 0;
+};
+
+}  // namespace graphics::renderer
+
+#endif  // OFFSCREEN_TARGET_HPP
@@ -0,0 +1,167 @@
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace graphics::renderer {
+
+constexpr int k_radix_bits = 8;
+constexpr size_t k_radix_buckets = size_t{1} << k_radix_bits;
+
+draw_item make_draw_item(const utilities::mesh_data& mesh,
+                         GLuint program,
+                         GLuint material,
+                         float depth,
+                         GLsizei instance_count) {
+  draw_item item;
+  item.program = program;
+  item.vertex_array = mesh.vertex_array_object;
+  item.material = material;
+  item.depth = depth;
+  item.count = mesh.count;
+  item.indexed = mesh.indexed;
+  item.instance_count = instance_count;
+  item.base_instance = mesh.matrix_buffer.base_instance();
+  return item;
+}
+
+draw_item make_draw_item(const utilities::mesh_data& mesh,
+                         const utilities::submesh& part,
+                         GLuint program,
+                         GLuint material,
+                         float depth,
+                         GLsizei instance_count) {
+  draw_item item = make_draw_item(mesh, program, material, depth, instance_count);
+  item.count = part.count;
+  item.first_index = part.first_index;
+  item.base_vertex = part.base_vertex;
+  return item;
+}
+
+uint64_t make_sort_key(const draw_item& item) {
+  const uint64_t max_depth = (uint64_t{1} << 24) - 1;
+  // NaN passes through clamp and has no integer value
+  const float unit_depth =
+      std::isfinite(item.depth) ? std::clamp(item.depth, 0.f, 1.f) : 0.f;
+  const uint64_t depth = unit_depth * max_depth;
+
+  return (uint64_t{item.program & 0xfffu} << 52) |
+         (uint64_t{item.vertex_array & 0xfffu} << 40) |
+         (uint64_t{item.material & 0xffffu} << 24) | depth;
+}
+
+void draw_queue::set_material_binder(material_binder binder) {
+  m_material_binder = std::move(binder);
+}
+
+void draw_queue::submit(const draw_item& item) {
+  m_items.push_back(item);
+}
+
+void draw_queue::flush() {
+  const size_t n = m_items.size();
+
+  sort_entry* entries;
+  sort_entry* scratch;
+  if (m_arena) {
+    entries = m_arena->allocate_array<sort_entry>(n);
+    scratch = m_arena->allocate_array<sort_entry>(n);
+  } else {
+    m_entries.resize(n);
+    m_scratch.resize(n);
+    entries = m_entries.data();
+    scratch = m_scratch.data();
+  }
+  const sort_entry* sorted = sort(entries, scratch);
+
+  m_stats = draw_stats{};
+
+  const draw_item* previous = nullptr;
+  for (size_t i = 0; i < n; ++i) {
+    const draw_item& item = m_items[sorted[i].index];
+
+    const bool program_changed = !previous || previous->program != item.program;
+    if (program_changed) {
+      glUseProgram(item.program);
+      ++m_stats.program_changes;
+    }
+
+    if (!previous || previous->vertex_array != item.vertex_array) {
+      glBindVertexArray(item.vertex_array);
+      ++m_stats.vertex_array_changes;
+    }
+
+    if (program_changed || previous->material != item.material) {
+      if (m_material_binder) {
+        m_material_binder(item.program, item.material);
+      }
+      ++m_stats.material_changes;
+    }
+
+    draw(item);
+    ++m_stats.draws;
+
+    previous = &item;
+  }
+
+  m_items.clear();
+}
+
+draw_queue::sort_entry* draw_queue::sort(sort_entry* entries, sort_entry* scratch) {
+  const size_t n = m_items.size();
+
+  for (size_t i = 0; i < n; ++i) {
+    entries[i] = {make_sort_key(m_items[i]), static_cast<uint32_t>(i)};
+  }
+
+  // least significant digit first; stable, so every pass keeps the order of
+  // the less significant digits
+  for (int shift = 0; shift < 64; shift += k_radix_bits) {
+    std::array<size_t, k_radix_buckets> offsets{};
+    for (size_t i = 0; i < n; ++i) {
+      ++offsets[(entries[i].key >> shift) & (k_radix_buckets - 1)];
+    }
+
+    // all keys share this digit, nothing to reorder
+    if (std::find(offsets.begin(), offsets.end(), n) != offsets.end()) {
+      continue;
+    }
+
+    size_t sum = 0;
+    for (auto& offset : offsets) {
+      sum += std::exchange(offset, sum);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+      const sort_entry& entry = entries[i];
+      scratch[offsets[(entry.key >> shift) & (k_radix_buckets - 1)]++] = entry;
+    }
+    std::swap(entries, scratch);
+  }
+
+  return entries;
+}
+
+void draw_queue::draw(const draw_item& item) {
+  if (item.indirect_buffer != 0) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, item.indirect_buffer);
+    if (item.indexed) {
+      glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+    } else {
+      glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+    }
+  } else if (item.indexed) {
+    const size_t first_byte = item.first_index * sizeof(GLuint);
+    const auto offset = reinterpret_cast<const void*>(first_byte);
+    glDrawElementsInstancedBaseVertexBaseInstance(
+        GL_TRIANGLES, item.count, GL_UNSIGNED_INT, offset, item.instance_count,
+        item.base_vertex, item.base_instance);
+  } else {
+    glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, item.count,
+                                      item.instance_count, item.base_instance);
+  }
+}
+
+}  // namespace graphics::renderer
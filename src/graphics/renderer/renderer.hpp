@@ -1,10 +1,116 @@
 #ifndef RENDERER_HPP
 #define RENDERER_HPP
 
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <utils/cube_mesh.hpp>
+#include <utils/frame_arena.hpp>
+
 namespace graphics::renderer {
 
+/* One instanced draw call and the state it needs. */
+struct draw_item {
+  GLuint program;
+  GLuint vertex_array;
+  GLuint material;
+
+  // view depth normalized to [0, 1]; items with equal state are drawn front to
+  // back
+  float depth;
+
+  // number of vertices, or of indices if indexed
+  GLsizei count;
+  bool indexed;
+  GLsizei instance_count;
+  GLuint base_instance;
+
+  // range of a submesh in shared buffers, only used if indexed
+  GLuint first_index = 0;
+  GLint base_vertex = 0;
+
+  // when non-zero, the draw parameters are read from this indirect buffer
+  GLuint indirect_buffer = 0;
+};
+
+/* Draw item for instances of a mesh read from the current region of its
+ * instance buffer. */
+draw_item make_draw_item(const utilities::mesh_data& mesh,
+                         GLuint program,
+                         GLuint material,
+                         float depth,
+                         GLsizei instance_count);
+
+/* Same as make_draw_item for one submesh of a mesh made with
+ * utilities::make_shared_mesh_elements. */
+draw_item make_draw_item(const utilities::mesh_data& mesh,
+                         const utilities::submesh& part,
+                         GLuint program,
+                         GLuint material,
+                         float depth,
+                         GLsizei instance_count);
+
+/* Key that orders draw items by program, then vertex array, then material,
+ * then depth. From the most significant bit: 12 bits of program name, 12 bits
+ * of vertex array name, 16 bits of material and 24 bits of depth. Names that do
+ * not fit only make the ordering less effective, since state changes are
+ * detected from the items themselves. Depths outside [0, 1] are clamped, and
+ * NaN sorts as 0. */
+uint64_t make_sort_key(const draw_item& item);
+
+/* Number of draws and state changes issued by the last flush. */
+struct draw_stats {
+  size_t draws = 0;
+  size_t program_changes = 0;
+  size_t vertex_array_changes = 0;
+  size_t material_changes = 0;
+};
+
+/* Renderer that collects the draw items of a frame, radix sorts them by their
+ * sort keys and submits them with as few program, vertex array and material
+ * changes as possible. */
+class draw_queue {
+ public:
+  /* Called with the program bound whenever the program or material changes
+   * between two draws, to set the material's uniforms. */
+  using material_binder = std::function<void(GLuint program, GLuint material)>;
+
+  void set_material_binder(material_binder binder);
+
+  /* Takes the sort keys of every flush from the arena instead of buffers kept
+   * by the queue. The arena must not be reset between submit and flush. */
+  void set_frame_arena(utilities::frame_arena* arena) { m_arena = arena; }
+
+  void submit(const draw_item& item);
+
+  /* Sorts and draws all submitted items, then clears the queue. */
+  void flush();
+
+  const draw_stats& stats() const { return m_stats; }
+
+ private:
+  struct sort_entry {
+    uint64_t key;
+    uint32_t index;
+  };
+
+  std::vector<draw_item> m_items;
+  std::vector<sort_entry> m_entries;
+  std::vector<sort_entry> m_scratch;
+  utilities::frame_arena* m_arena = nullptr;
+
+  material_binder m_material_binder;
+  draw_stats m_stats;
+
+  /* Returns the entries of all items, sorted by key, in entries or scratch. */
+  sort_entry* sort(sort_entry* entries, sort_entry* scratch);
 
+  static void draw(const draw_item& item);
+};
 
-} // namespace graphics::renderer
+}  // namespace graphics::renderer
 
-#endif // RENDERER_HPP
\ No newline at end of file
+#endif  // RENDERER_HPP
@@ -0,0 +1,115 @@
+#include "frame_uniforms.hpp"
+
+#include <glm/ext.hpp>
+
+#include <algorithm>
+
+namespace graphics::shader {
+
+const std::string frame_uniforms_src =
+    "#define MAX_NUM_LIGHTS " + std::to_string(k_max_num_lights) + "\n" +
+    "#define FRAME_UNIFORMS_BINDING " + std::to_string(k_frame_uniforms_binding) +
+    "\n" + R"(
+
+layout(std140, binding = FRAME_UNIFORMS_BINDING) uniform frame_data
+{
+   mat4 u_viewMat;
+   mat4 u_projMat;
+
+   // The camera's position in world coordinates
+   vec3 u_cameraPosition;
+
+   vec3 u_AmbientProduct;
+   vec3 u_DiffuseProduct;
+   vec3 u_SpecularProduct;
+
+   vec4 u_lightPositions[MAX_NUM_LIGHTS]; // xyz - position
+   int u_numLights;
+};
+
+)";
+
+frame_uniforms::frame_uniforms() : m_data{} {
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(frame_uniforms_data), NULL, GL_DYNAMIC_DRAW);
+
+  // default camera
+  glm::vec3 camera_position(1.f, 0.f, -5.f);
+  set_camera_pos(camera_position);
+
+  glm::mat4 view_matrix =
+      glm::lookAt(camera_position, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+  set_view_matrix(view_matrix);
+
+  glm::mat4 proj_matrix =
+      glm::perspective(glm::pi<float>() * 60.f / 180.f, 640 / (float)480, 0.1f, 100.f);
+  set_projection_matrix(proj_matrix);
+
+  // light products
+  glm::vec3 light_ambient(0.01f, 0.01f, 0.01f);
+  glm::vec3 ambient_product = light_ambient;
+  set_ambient_product(ambient_product);
+
+  glm::vec3 light_diffuse(1.f, 1.f, 1.f);
+  glm::vec3 diffuse_product = light_diffuse;
+  set_diffuse_product(diffuse_product);
+
+  glm::vec3 light_specular(1.f, 1.f, 1.f);
+  glm::vec3 material_specular(1.f, 1.f, 1.f);
+  glm::vec3 specular_product = light_specular * material_specular;
+  set_specular_product(specular_product);
+
+  // lights
+  set_num_lights(2);
+  set_light_position(0, glm::vec3(-2.5f, 2.5f, 1.f));
+  set_light_position(1, glm::vec3(2.5f, 2.5f, 1.f));
+
+  upload();
+}
+
+frame_uniforms::~frame_uniforms() {
+  glDeleteBuffers(1, &m_buffer);
+}
+
+void frame_uniforms::set_view_matrix(const glm::mat4& m) {
+  m_data.view_matrix = m;
+}
+
+void frame_uniforms::set_projection_matrix(const glm::mat4& m) {
+  m_data.projection_matrix = m;
+}
+
+void frame_uniforms::set_camera_pos(const glm::vec3& pos) {
+  m_data.camera_position = glm::vec4(pos, 1.f);
+}
+
+void frame_uniforms::set_ambient_product(const glm::vec3& v) {
+  m_data.ambient_product = glm::vec4(v, 0.f);
+}
+
+void frame_uniforms::set_diffuse_product(const glm::vec3& v) {
+  m_data.diffuse_product = glm::vec4(v, 0.f);
+}
+
+void frame_uniforms::set_specular_product(const glm::vec3& v) {
+  m_data.specular_product = glm::vec4(v, 0.f);
+}
+
+void frame_uniforms::set_light_position(size_t index, const glm::vec3& v) {
+  if (index < k_max_num_lights) {
+    m_data.light_positions[index] = glm::vec4(v, 1.f);
+  }
+}
+
+void frame_uniforms::set_num_lights(int n) {
+  m_data.num_lights = std::clamp(n, 0, k_max_num_lights);
+}
+
+void frame_uniforms::upload() {
+  glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(frame_uniforms_data), &m_data);
+  glBindBufferBase(GL_UNIFORM_BUFFER, k_frame_uniforms_binding, m_buffer);
+}
+
+}  // namespace graphics::shader
@@ -0,0 +1,81 @@
+#ifndef FRAME_UNIFORMS_HPP
+#define FRAME_UNIFORMS_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+
+namespace graphics::shader {
+
+/* Uniform buffer binding point of the per-frame block, shared by all
+ * programs. */
+constexpr GLuint k_frame_uniforms_binding = 0;
+
+constexpr int k_max_num_lights = 12;
+
+/* GLSL declaration of the per-frame uniform block, to be inserted after the
+ * #version directive of every program that reads it. */
+extern const std::string frame_uniforms_src;
+
+/* Camera and lighting state shared by all programs, in std140 layout. vec3s
+ * are stored as vec4s. */
+struct frame_uniforms_data {
+  glm::mat4 view_matrix;
+  glm::mat4 projection_matrix;
+  glm::vec4 camera_position;
+
+  glm::vec4 ambient_product;
+  glm::vec4 diffuse_product;
+  glm::vec4 specular_product;
+
+  glm::vec4 light_positions[k_max_num_lights];
+  GLint num_lights;
+  GLint padding[3];
+};
+
+static_assert(sizeof(frame_uniforms_data) == 400,
+              "frame_uniforms_data must match the std140 block");
+
+/* Uniform buffer with the per-frame block. The setters only change the CPU
+ * copy, which upload writes to the buffer in one call, so they can be called
+ * in any order and with any program bound. */
+class frame_uniforms {
+ public:
+  /* Creates the buffer with default camera and lights, and binds it to
+   * k_frame_uniforms_binding. */
+  frame_uniforms();
+
+  ~frame_uniforms();
+
+  frame_uniforms(const frame_uniforms&) = delete;
+  frame_uniforms& operator=(const frame_uniforms&) = delete;
+
+  void set_view_matrix(const glm::mat4& m);
+
+  void set_projection_matrix(const glm::mat4& m);
+
+  void set_camera_pos(const glm::vec3& pos);
+
+  void set_ambient_product(const glm::vec3& v);
+
+  void set_diffuse_product(const glm::vec3& v);
+
+  void set_specular_product(const glm::vec3& v);
+
+  void set_light_position(size_t index, const glm::vec3& v);
+
+  void set_num_lights(int n);
+
+  /* Writes the block to the buffer and binds it to k_frame_uniforms_binding.
+   * Call once per frame after the setters, before the draw calls. */
+  void upload();
+
+ private:
+  frame_uniforms_data m_data;
+  GLuint m_buffer = 0;
+};
+
+}  // namespace graphics::shader
+
+#endif  // FRAME_UNIFORMS_HPP
@@ -0,0 +1,211 @@
+#include "light_clusters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace graphics::shader {
+
+const std::string light_clusters_src =
+    "#extension GL_ARB_shader_storage_buffer_object : require\n"
+    "#define LIGHTS_BINDING " + std::to_string(k_lights_binding) + "\n" +
+    "#define CLUSTERS_BINDING " + std::to_string(k_clusters_binding) + "\n" +
+    "#define LIGHT_INDICES_BINDING " + std::to_string(k_light_indices_binding) +
+    "\n" + R"(
+
+struct point_light
+{
+   vec4 position_radius; // xyz - position, w - radius
+   vec4 color; // rgb - color
+};
+
+layout(std430, binding = LIGHTS_BINDING) readonly buffer light_data
+{
+   point_light u_lights[];
+};
+
+layout(std430, binding = CLUSTERS_BINDING) readonly buffer cluster_data
+{
+   uvec4 u_clusterGrid; // x - tiles in x, y - tiles in y, z - depth slices
+   vec4 u_clusterDepth; // x - near, y - far, zw - viewport size
+   uvec2 u_clusters[]; // x - offset into u_lightIndices, y - number of lights
+};
+
+layout(std430, binding = LIGHT_INDICES_BINDING) readonly buffer light_index_data
+{
+   uint u_lightIndices[];
+};
+
+uvec2 clusterLights(vec2 fragCoord, float viewDepth)
+{
+   uvec2 tile = uvec2(clamp(fragCoord / u_clusterDepth.zw * vec2(u_clusterGrid.xy),
+                            vec2(0.0), vec2(u_clusterGrid.xy) - 1.0));
+
+   // exponential slices, matching light_clusters::update
+   float near = u_clusterDepth.x;
+   float far = u_clusterDepth.y;
+   float slice = log(max(viewDepth, near) / near) / log(far / near);
+   uint z = uint(clamp(slice * float(u_clusterGrid.z), 0.0, float(u_clusterGrid.z) - 1.0));
+
+   return u_clusters[(z * u_clusterGrid.y + tile.y) * u_clusterGrid.x + tile.x];
+}
+
+)";
+
+// size of the grid and depth header in front of the clusters
+constexpr size_t k_header_words = 8;
+
+light_clusters::light_clusters() {
+  glGenBuffers(1, &m_lights_buffer);
+  glGenBuffers(1, &m_clusters_buffer);
+  glGenBuffers(1, &m_light_indices_buffer);
+
+  m_clusters.resize(k_header_words + 2 * k_num_clusters);
+}
+
+light_clusters::~light_clusters() {
+  glDeleteBuffers(1, &m_lights_buffer);
+  glDeleteBuffers(1, &m_clusters_buffer);
+  glDeleteBuffers(1, &m_light_indices_buffer);
+}
+
+bool light_clusters::is_supported() {
+  return GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_shader_storage_buffer_object;
+}
+
+/* Returns the depth slice of a positive view depth. */
+static uint32_t depth_slice(float depth, float near, float far) {
+  const float slice = std::log(std::max(depth, near) / near) / std::log(far / near);
+  return std::clamp<int>(slice * light_clusters::k_slices, 0,
+                         light_clusters::k_slices - 1);
+}
+
+/* Returns the tile containing a normalized device coordinate. */
+static uint32_t tile(float ndc, uint32_t n_tiles) {
+  return std::clamp<int>((ndc * 0.5f + 0.5f) * n_tiles, 0, n_tiles - 1);
+}
+
+/* Replaces the buffer's storage with size bytes of data. Buffers bound to
+ * runtime-sized arrays may not be empty, so at least one word is allocated. */
+static void upload(GLuint buffer, const void* data, size_t size) {
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(size, sizeof(uint32_t)),
+               NULL, GL_STREAM_DRAW);
+  if (size > 0) {
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+  }
+}
+
+void light_clusters::update(const std::vector<point_light>& lights,
+                            const glm::mat4& view_matrix,
+                            const glm::mat4& proj_matrix,
+                            float near,
+                            float far,
+                            int viewport_width,
+                            int viewport_height) {
+  const size_t n_lights = lights.size();
+  m_ranges.resize(n_lights);
+
+  uint32_t* counts = m_clusters.data() + k_header_words;
+  std::fill(counts, counts + 2 * k_num_clusters, 0);
+
+  // find the clusters each light's sphere overlaps and count them per cluster
+  for (size_t i = 0; i < n_lights; ++i) {
+    const glm::vec3 center = glm::vec3(view_matrix * glm::vec4(lights[i].position, 1.f));
+    const float r = lights[i].radius;
+    cluster_range& range = m_ranges[i];
+
+    // view space looks down the negative z axis
+    const float z_min = -center.z - r;
+    const float z_max = -center.z + r;
+    if (z_max < near || z_min > far) {
+      range.min[0] = 1;  // empty range
+      range.max[0] = 0;
+      continue;
+    }
+
+    range.min[2] = depth_slice(z_min, near, far);
+    range.max[2] = depth_slice(z_max, near, far);
+
+    // the sphere's screen rectangle, from the corners of its bounding box;
+    // spheres crossing the near plane may cover the whole screen
+    glm::vec2 ndc_min(-1.f);
+    glm::vec2 ndc_max(1.f);
+    if (z_min > near) {
+      ndc_min = glm::vec2(1.f);
+      ndc_max = glm::vec2(-1.f);
+      for (int corner = 0; corner < 8; ++corner) {
+        const glm::vec3 offset((corner & 1) ? r : -r, (corner & 2) ? r : -r,
+                               (corner & 4) ? r : -r);
+        const glm::vec4 clip = proj_matrix * glm::vec4(center + offset, 1.f);
+        const glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+        ndc_min = glm::min(ndc_min, ndc);
+        ndc_max = glm::max(ndc_max, ndc);
+      }
+    }
+
+    if (ndc_min.x > 1.f || ndc_min.y > 1.f || ndc_max.x < -1.f || ndc_max.y < -1.f) {
+      range.min[0] = 1;
+      range.max[0] = 0;
+      continue;
+    }
+
+    range.min[0] = tile(ndc_min.x, k_tiles_x);
+    range.max[0] = tile(ndc_max.x, k_tiles_x);
+    range.min[1] = tile(ndc_min.y, k_tiles_y);
+    range.max[1] = tile(ndc_max.y, k_tiles_y);
+
+    for (uint32_t z = range.min[2]; z <= range.max[2]; ++z) {
+      for (uint32_t y = range.min[1]; y <= range.max[1]; ++y) {
+        for (uint32_t x = range.min[0]; x <= range.max[0]; ++x) {
+          ++counts[2 * ((z * k_tiles_y + y) * k_tiles_x + x) + 1];
+        }
+      }
+    }
+  }
+
+  // offsets from the counts, then fill in the light indices cluster by cluster
+  uint32_t offset = 0;
+  for (uint32_t c = 0; c < k_num_clusters; ++c) {
+    counts[2 * c] = offset;
+    offset += std::exchange(counts[2 * c + 1], 0);
+  }
+  m_light_indices.resize(offset);
+
+  for (size_t i = 0; i < n_lights; ++i) {
+    const cluster_range& range = m_ranges[i];
+    if (range.min[0] > range.max[0]) {
+      continue;
+    }
+
+    for (uint32_t z = range.min[2]; z <= range.max[2]; ++z) {
+      for (uint32_t y = range.min[1]; y <= range.max[1]; ++y) {
+        for (uint32_t x = range.min[0]; x <= range.max[0]; ++x) {
+          uint32_t* cluster = counts + 2 * ((z * k_tiles_y + y) * k_tiles_x + x);
+          m_light_indices[cluster[0] + cluster[1]++] = i;
+        }
+      }
+    }
+  }
+
+  // header, laid out as u_clusterGrid and u_clusterDepth
+  const float depth[4] = {near, far, static_cast<float>(viewport_width),
+                          static_cast<float>(viewport_height)};
+  m_clusters[0] = k_tiles_x;
+  m_clusters[1] = k_tiles_y;
+  m_clusters[2] = k_slices;
+  m_clusters[3] = n_lights;
+  std::copy(depth, depth + 4, reinterpret_cast<float*>(m_clusters.data() + 4));
+
+  upload(m_lights_buffer, lights.data(), n_lights * sizeof(point_light));
+  upload(m_clusters_buffer, m_clusters.data(), m_clusters.size() * sizeof(uint32_t));
+  upload(m_light_indices_buffer, m_light_indices.data(),
+         m_light_indices.size() * sizeof(uint32_t));
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_lights_binding, m_lights_buffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_clusters_binding, m_clusters_buffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_light_indices_binding,
+                   m_light_indices_buffer);
+}
+
+}  // namespace graphics::shader
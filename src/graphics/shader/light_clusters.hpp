@@ -0,0 +1,90 @@
+#ifndef LIGHT_CLUSTERS_HPP
+#define LIGHT_CLUSTERS_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace graphics::shader {
+
+/* Shader storage buffer binding points of the clustered lighting buffers. */
+constexpr GLuint k_lights_binding = 3;
+constexpr GLuint k_clusters_binding = 4;
+constexpr GLuint k_light_indices_binding = 5;
+
+/* GLSL declarations of the clustered lighting buffers and of
+ * clusterLights(fragCoord, viewDepth), which returns the offset and count of
+ * the fragment's lights in u_lightIndices. Must be inserted right after the
+ * #version directive, since it enables GL_ARB_shader_storage_buffer_object. */
+extern const std::string light_clusters_src;
+
+/* Point light in std430 layout. Its contribution fades to zero at radius. */
+struct point_light {
+  glm::vec3 position;
+  float radius;
+  glm::vec3 color;
+  float padding;
+};
+
+static_assert(sizeof(point_light) == 32, "point_light must match std430 layout");
+
+/* Lights in a shader storage buffer and a view-space cluster grid of
+ * k_tiles_x * k_tiles_y screen tiles times k_slices exponential depth slices.
+ * Every frame, each light is assigned to the clusters its bounding sphere
+ * overlaps, so that a fragment only shades the lights of its own cluster.
+ *
+ * Requires GL 4.3 or GL_ARB_shader_storage_buffer_object; check is_supported
+ * before constructing. */
+class light_clusters {
+ public:
+  static constexpr uint32_t k_tiles_x = 16;
+  static constexpr uint32_t k_tiles_y = 9;
+  static constexpr uint32_t k_slices = 24;
+  static constexpr uint32_t k_num_clusters = k_tiles_x * k_tiles_y * k_slices;
+
+  light_clusters();
+
+  ~light_clusters();
+
+  light_clusters(const light_clusters&) = delete;
+  light_clusters& operator=(const light_clusters&) = delete;
+
+  static bool is_supported();
+
+  /* Assigns the lights to the clusters of the view frustum described by the
+   * matrices and depth range, uploads lights and clusters and binds the
+   * buffers. Call once per frame before the draw calls. */
+  void update(const std::vector<point_light>& lights,
+              const glm::mat4& view_matrix,
+              const glm::mat4& proj_matrix,
+              float near,
+              float far,
+              int viewport_width,
+              int viewport_height);
+
+  /* Number of light-cluster pairs assigned by the last update. */
+  size_t num_assignments() const { return m_light_indices.size(); }
+
+ private:
+  /* Clusters overlapped by one light, as inclusive ranges. */
+  struct cluster_range {
+    uint32_t min[3];
+    uint32_t max[3];
+  };
+
+  GLuint m_lights_buffer = 0;
+  GLuint m_clusters_buffer = 0;
+  GLuint m_light_indices_buffer = 0;
+
+  // scratch data kept between frames to avoid reallocating
+  std::vector<cluster_range> m_ranges;
+  std::vector<uint32_t> m_clusters;
+  std::vector<uint32_t> m_light_indices;
+};
+
+}  // namespace graphics::shader
+
+#endif  // LIGHT_CLUSTERS_HPP
@@ -0,0 +1,79 @@
+#include "material_table.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace graphics::shader {
+
+const std::string material_table_src =
+    "#define MAX_NUM_MATERIALS " + std::to_string(k_max_num_materials) + "\n" +
+    "#define MATERIAL_TABLE_BINDING " + std::to_string(k_material_table_binding) +
+    "\n" + R"(
+
+struct material
+{
+   vec4 diffuse_shininess; // rgb - diffuse color, a - shininess
+};
+
+layout(std140, binding = MATERIAL_TABLE_BINDING) uniform material_table
+{
+   material u_materials[MAX_NUM_MATERIALS];
+};
+
+)";
+
+material_table::material_table() {
+  m_materials.reserve(k_max_num_materials);
+
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+  glBufferData(GL_UNIFORM_BUFFER, k_max_num_materials * sizeof(material), NULL,
+               GL_DYNAMIC_DRAW);
+
+  // the former uniform cube color
+  add({glm::vec3(0.75f, 0.75f, 0.f), 100.f});
+
+  upload();
+}
+
+material_table::~material_table() {
+  glDeleteBuffers(1, &m_buffer);
+}
+
+uint32_t material_table::add(const material& m) {
+  if (m_materials.size() == k_max_num_materials) {
+    std::cout << "Error: material table is full\n";
+    return 0;
+  }
+
+  m_materials.push_back(m);
+  set(m_materials.size() - 1, m);
+  return m_materials.size() - 1;
+}
+
+void material_table::set(uint32_t index, const material& m) {
+  m_materials[index] = m;
+
+  if (m_dirty_begin == m_dirty_end) {
+    m_dirty_begin = index;
+    m_dirty_end = index + 1;
+  } else {
+    m_dirty_begin = std::min<size_t>(m_dirty_begin, index);
+    m_dirty_end = std::max<size_t>(m_dirty_end, index + 1);
+  }
+}
+
+void material_table::upload() {
+  glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+
+  if (m_dirty_begin != m_dirty_end) {
+    glBufferSubData(GL_UNIFORM_BUFFER, m_dirty_begin * sizeof(material),
+                    (m_dirty_end - m_dirty_begin) * sizeof(material),
+                    m_materials.data() + m_dirty_begin);
+    m_dirty_begin = m_dirty_end = 0;
+  }
+
+  glBindBufferBase(GL_UNIFORM_BUFFER, k_material_table_binding, m_buffer);
+}
+
+}  // namespace graphics::shader
@@ -0,0 +1,70 @@
+#ifndef MATERIAL_TABLE_HPP
+#define MATERIAL_TABLE_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace graphics::shader {
+
+/* Uniform buffer binding point of the material table. */
+constexpr GLuint k_material_table_binding = 1;
+
+/* Materials fit in the 16 KiB every implementation allows for a uniform
+ * block. */
+constexpr size_t k_max_num_materials = 1024;
+
+/* GLSL declaration of the material table, to be inserted after the #version
+ * directive of every program that reads it. Declares u_materials, indexed by
+ * the instances' material index. */
+extern const std::string material_table_src;
+
+/* One entry of the table, in std140 layout. */
+struct material {
+  glm::vec3 diffuse_color;
+  float shininess;
+};
+
+static_assert(sizeof(material) == 16, "material must match the std140 array");
+
+/* Uniform buffer with the materials that instances refer to by index, so
+ * instances with different materials are drawn in one call. Starts with the
+ * yellow default material at index 0. */
+class material_table {
+ public:
+  /* Creates the buffer and binds it to k_material_table_binding. */
+  material_table();
+
+  ~material_table();
+
+  material_table(const material_table&) = delete;
+  material_table& operator=(const material_table&) = delete;
+
+  /* Appends a material and returns its index, or 0 if the table is full. */
+  uint32_t add(const material& m);
+
+  /* Changes an existing material. */
+  void set(uint32_t index, const material& m);
+
+  size_t size() const { return m_materials.size(); }
+
+  /* Writes the changed materials to the buffer and binds it to
+   * k_material_table_binding. */
+  void upload();
+
+ private:
+  std::vector<material> m_materials;
+  GLuint m_buffer = 0;
+
+  // range of materials changed since the last upload
+  size_t m_dirty_begin = 0;
+  size_t m_dirty_end = 0;
+};
+
+}  // namespace graphics::shader
+
+#endif  // MATERIAL_TABLE_HPP
@@ -7,11 +7,14 @@
 #include <iostream>
 #include <string>
 
+#include <shader/frame_uniforms.hpp>
+#include <shader/light_clusters.hpp>
+#include <shader/material_table.hpp>
 #include <shader/shader.hpp>
 
 namespace graphics::shader {
 
-const std::string vert_src = R"(
+const std::string phong_vert_src = R"(
 
 #version 420
 
@@ -19,17 +22,15 @@ const std::string vert_src = R"(
 layout(location = 0) in vec4 i_position; // xyz - position
 layout(location = 1) in vec3 i_normal; // xyz - normal
 layout(location = 2) in vec2 i_texcoord0; // xy - texture coords
-layout(location = 3) in mat4 instance_model_mat;
 
-// TODO: add model matrix and color buffers to input
+#ifdef COMPACT_INSTANCES
+layout(location = 3) in vec4 instance_position_scale; // xyz - position, w - scale
+layout(location = 4) in vec4 instance_rotation_material; // xyz - quaternion's vector part, w - material
+#else
+layout(location = 3) in mat4 instance_model_mat; // [0].w - material
+#endif
 
-// matrices
-// uniform mat4 u_modelMat; // TODO: buffer instead
-uniform mat4 u_viewMat;
-uniform mat4 u_projMat;
-
-// The camera's position in world coordinates
-uniform vec3 u_cameraPosition;
+// matrices and camera position come from the frame_data block
 
 // data for fragment shader
 out vec3 o_normal;
@@ -37,18 +38,50 @@ out vec3 o_toCamera;
 out vec2 o_texcoords;
 
 out vec3 o_worldPos;
+flat out uint o_material;
+
+// depth pre-passes run this shader too, and their depths must match exactly
+invariant gl_Position;
+
 ///////////////////////////////////////////////////////////////////
 
+// rotates v by the unit quaternion q
+vec3 rotate(vec4 q, vec3 v)
+{
+   return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
 void main(void)
 {
+#ifdef COMPACT_INSTANCES
+   // unit quaternion with a non-negative real part
+   vec3 axis = instance_rotation_material.xyz;
+   vec4 orientation = vec4(axis, sqrt(max(1.0 - dot(axis, axis), 0.0)));
+
+   // position in world space
+   vec3 scaled = instance_position_scale.w * i_position.xyz;
+   vec4 worldPosition =
+      vec4(rotate(orientation, scaled) + instance_position_scale.xyz, 1.0);
+
+   // normal in world space, unaffected by the uniform scale
+   o_normal = normalize(rotate(orientation, i_normal));
+
+   o_material = uint(instance_rotation_material.w + 0.5);
+#else
+   // the bottom row holds the material instead of (0, 0, 0, 1)
+   mat4 modelMat = instance_model_mat;
+   o_material = uint(modelMat[0].w + 0.5);
+   modelMat[0].w = 0.0;
+
    // position in world space
-   vec4 worldPosition = instance_model_mat * i_position; // vec4(i_position, 1);
+   vec4 worldPosition = modelMat * i_position; // vec4(i_position, 1);
+
+   // normal in world space
+   o_normal = normalize( (modelMat * vec4(i_normal, 0.0)).xyz );
+#endif
 
    //
    o_worldPos = worldPosition.xyz;
-   
-   // normal in world space
-   o_normal = normalize( (instance_model_mat * vec4(i_normal, 0.0)).xyz );
 
    // direction to camera
    o_toCamera = normalize(u_cameraPosition - worldPosition.xyz);
@@ -62,34 +95,14 @@ void main(void)
 
 )";
 
-const std::string frag_src = R"(
-
-#version 420
-
-// data from vertex shader
-in vec3 o_normal;
-in vec3 o_toCamera;
-in vec2 o_texcoords;
-in vec3 o_worldPos;
-
-// color for framebuffer
-out vec4 resultingColor;
+const std::string phong_lighting_src = R"(
 
 /////////////////////////////////////////////////////////
 
-// texture with diffuse color of the object
-uniform vec3 u_diffuse_color;
-// uniform sampler2D u_diffuseTexture; // TODO: put colors in buffer object instead
-
-uniform vec3 u_AmbientProduct;
-uniform vec3 u_DiffuseProduct;
-uniform vec3 u_SpecularProduct;
-
-uniform float u_matShininess; // = 64;
-
-#define MAX_NUM_LIGHTS 12
-uniform vec3 u_lightPositions[MAX_NUM_LIGHTS];
-uniform int u_numLights;
+// light products and positions come from the frame_data block; the surface's
+// diffuse color and shininess are set before calling shade
+vec3 diffuseColor;
+float matShininess;
 
 /////////////////////////////////////////////////////////
 
@@ -112,7 +125,7 @@ vec3 specularLighting(in vec3 N, in vec3 L, in vec3 V)
 {
 	vec3 H = normalize(L + V);
 	
-   	float Ks = pow(max(dot(N, H), 0.0), u_matShininess);   
+   	float Ks = pow(max(dot(N, H), 0.0), matShininess);   
 	vec3 specular = Ks*u_SpecularProduct;
 
 	// discard the specular highlight if the light's behind the vertex    
@@ -124,25 +137,42 @@ vec3 specularLighting(in vec3 N, in vec3 L, in vec3 V)
 	return specular;
 }
 
-
-
-void main(void)
+// returns the color of a surface point with normal N seen from direction V
+vec3 shade(in vec3 N, in vec3 V, in vec3 worldPos, in vec2 fragCoord)
 {
-   // normalize vectors after interpolation
-   vec3 V = normalize(o_toCamera); 
-   vec3 N = normalize(o_normal);
-
    // get Blinn-Phong reflectance components
    vec3 Iamb = ambientLighting();
-   
-   // diffuse color of the object from texture
-   // vec3 diffuseColor = texture(u_diffuseTexture, o_texcoords).rgb;
-   
+
+   // Apply ambient light once, whatever the number of lights
+   vec3 colorSum = diffuseColor * Iamb;
+
+#ifdef CLUSTERED_LIGHTING
+   // Apply light from the lights of the fragment's cluster
+   float viewDepth = -(u_viewMat * vec4(worldPos, 1.0)).z;
+   uvec2 cluster = clusterLights(fragCoord, viewDepth);
+
+   for(uint i = 0u; i < cluster.y; i++)
+   {
+		point_light light = u_lights[u_lightIndices[cluster.x + i]];
+		vec3 lightDir = light.position_radius.xyz - worldPos;
+		float lightDist = length(lightDir);
+
+		// fade out smoothly towards the light's radius
+		float falloff = clamp(1.0 - pow(lightDist / light.position_radius.w, 4.0), 0.0, 1.0);
+		float Kdi = falloff * falloff * 2 / max(lightDist, 2.0);
+
+		vec3 L = lightDir / max(lightDist, 1e-4);
+
+		vec3 Idif = diffuseLighting(N, L);
+		vec3 Ispe = specularLighting(N, L, V);
+
+		colorSum += diffuseColor * light.color.rgb * Kdi * (Idif + Ispe);
+   }
+#else
    // Apply light from all lights
-   vec3 colorSum = vec3(0.0, 0.0, 0.0);
    for(int i = 0; i < u_numLights; i++)
    {
-		vec3 lightDir = u_lightPositions[i] - o_worldPos;
+		vec3 lightDir = u_lightPositions[i].xyz - worldPos;
 		
 		float Kdi = 2 / max(length(lightDir), 2.0);
 
@@ -153,10 +183,45 @@ void main(void)
 		
 		// combination of all components and diffuse color of the object
 		// colorSum += diffuseColor * (Iamb + Kdi * (Idif + Ispe));
-        colorSum += u_diffuse_color * (Iamb + Kdi * (Idif + Ispe));
+        colorSum += diffuseColor * Kdi * (Idif + Ispe);
    }
-   
-   resultingColor = vec4(colorSum, 1.0);
+#endif
+
+   return colorSum;
+}
+
+)";
+
+const std::string frag_src = R"(
+
+#version 420
+
+// data from vertex shader
+in vec3 o_normal;
+in vec3 o_toCamera;
+in vec2 o_texcoords;
+in vec3 o_worldPos;
+flat in uint o_material;
+
+// color for framebuffer
+out vec4 resultingColor;
+
+// uniform sampler2D u_diffuseTexture;
+
+)" + phong_lighting_src + R"(void main(void)
+{
+   // the instance's material
+   diffuseColor = u_materials[o_material].diffuse_shininess.rgb;
+   matShininess = u_materials[o_material].diffuse_shininess.a;
+
+   // normalize vectors after interpolation
+   vec3 V = normalize(o_toCamera); 
+   vec3 N = normalize(o_normal);
+
+   // diffuse color of the object from texture
+   // vec3 diffuseColor = texture(u_diffuseTexture, o_texcoords).rgb;
+
+   resultingColor = vec4(shade(N, V, o_worldPos, gl_FragCoord.xy), 1.0);
 }
 
 )";
@@ -202,69 +267,28 @@ void main(void)
 
 )";
 
-phong_shader::phong_shader() {
-  // compile shader program
-  //   m_program = shader::compile_program(simple_vert_src.c_str(),
-  //   simple_frag_src.c_str());
-  m_program = shader::compile_program(vert_src.c_str(), frag_src.c_str());
-
-  // get uniform locations
-  u_model_mat = glGetUniformLocation(m_program, "u_modelMat");
-  u_view_mat = glGetUniformLocation(m_program, "u_viewMat");
-  u_proj_mat = glGetUniformLocation(m_program, "u_projMat");
-  u_camera_pos = glGetUniformLocation(m_program, "u_cameraPosition");
-
-  u_ambient_prod = glGetUniformLocation(m_program, "u_AmbientProduct");
-  u_diffuse_prod = glGetUniformLocation(m_program, "u_DiffuseProduct");
-  u_specular_prod = glGetUniformLocation(m_program, "u_SpecularProduct");
-  u_material_shininess = glGetUniformLocation(m_program, "u_matShininess");
-
-  u_light_positions = glGetUniformLocation(m_program, "u_lightPositions[0]");
-  u_num_lights = glGetUniformLocation(m_program, "u_numLights");
-
-  // initialize uniforms with default values
-  bind();
-
-  glm::mat4 model_matrix(1.f);
-  set_model_matrix(model_matrix);
-
-  glm::vec3 camera_position(1.f, 0.f, -5.f);
-  set_camera_pos(camera_position);
-
-  glm::mat4 view_matrix =
-      glm::lookAt(camera_position, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
-  set_view_matrix(view_matrix);
-
-  glm::mat4 proj_matrix =
-      glm::perspective(glm::pi<float>() * 60.f / 180.f, 640 / (float)480, 0.1f, 100.f);
-  set_projection_matrix(proj_matrix);
-
-  // light products
-  glm::vec3 light_ambient(0.01f, 0.01f, 0.01f);
-  glm::vec3 ambient_product = light_ambient;
-  set_ambient_product(ambient_product);
-
-  glm::vec3 light_diffuse(1.f, 1.f, 1.f);
-  glm::vec3 diffuse_product = light_diffuse;
-  set_diffuse_product(diffuse_product);
-
-  glm::vec3 light_specular(1.f, 1.f, 1.f);
-  glm::vec3 material_specular(1.f, 1.f, 1.f);
-  glm::vec3 specular_product = light_specular * material_specular;
-  set_specular_product(specular_product);
-
-  float material_shininess = 100.0;
-  set_material_shininess(material_shininess);
+phong_shader::phong_shader(utilities::instance_format format, bool clustered_lighting) {
+  std::string defines;
+  if (format == utilities::instance_format::compact) {
+    defines += "#define COMPACT_INSTANCES\n";
+  }
 
-  // lights
-  set_num_lights(2);
-  set_light_position(0, glm::vec3(-2.5f, 2.5f, 1.f));
-  set_light_position(1, glm::vec3(2.5f, 2.5f, 1.f));
+  // camera and lights are read from the shared per-frame uniform block
+  defines += frame_uniforms_src;
 
-  // uniform cube color
-  glUniform3f(glGetUniformLocation(m_program, "u_diffuse_color"), 0.75f, 0.75f, 0.f);
+  // the cluster declarations enable an extension and have to come first
+  std::string frag_defines = frame_uniforms_src + material_table_src;
+  if (clustered_lighting) {
+    frag_defines = light_clusters_src + "#define CLUSTERED_LIGHTING\n" + frag_defines;
+  }
 
-  print_uniform_locations();
+  // compile shader program
+  //   m_program = shader::compile_program(simple_vert_src.c_str(),
+  //   simple_frag_src.c_str());
+  const std::string vert = shader::with_defines(phong_vert_src, defines);
+  const std::string frag = shader::with_defines(frag_src, frag_defines);
+  m_pending = shader::compile_program_async(vert.c_str(), frag.c_str());
+  m_program = m_pending.program;
 }
 
 phong_shader::~phong_shader() {
@@ -273,66 +297,48 @@ phong_shader::~phong_shader() {
   // destroy program?
 }
 
-void phong_shader::bind() {
-  glUseProgram(m_program);
-}
-
-void phong_shader::set_model_matrix(const glm::mat4& m) {
-  glUniformMatrix4fv(u_model_mat, 1, GL_FALSE, glm::value_ptr(m));
-}
-
-void phong_shader::set_view_matrix(const glm::mat4& m) {
-  glUniformMatrix4fv(u_view_mat, 1, GL_FALSE, glm::value_ptr(m));
+bool phong_shader::ready() {
+  poll_program(m_pending);
+  return initialize();
 }
 
-void phong_shader::set_projection_matrix(const glm::mat4& m) {
-  glUniformMatrix4fv(u_proj_mat, 1, GL_FALSE, glm::value_ptr(m));
+bool phong_shader::wait() {
+  finish_program(m_pending);
+  return initialize();
 }
 
-void phong_shader::set_camera_pos(const glm::vec3& v) {
-  glUniform3f(u_camera_pos, v.x, v.y, v.z);
-}
+bool phong_shader::initialize() {
+  if (m_pending.status != program_status::linked || m_initialized) {
+    return m_initialized;
+  }
+  m_initialized = true;
 
-void phong_shader::set_ambient_product(const glm::vec3& v) {
-  glUniform3f(u_ambient_prod, v.x, v.y, v.z);
-}
+  // get uniform locations
+  u_model_mat = glGetUniformLocation(m_program, "u_modelMat");
 
-void phong_shader::set_diffuse_product(const glm::vec3& v) {
-  glUniform3f(u_diffuse_prod, v.x, v.y, v.z);
-}
+  // initialize uniforms with default values
+  bind();
 
-void phong_shader::set_specular_product(const glm::vec3& v) {
-  glUniform3f(u_specular_prod, v.x, v.y, v.z);
-}
+  glm::mat4 model_matrix(1.f);
+  set_model_matrix(model_matrix);
 
-void phong_shader::set_material_shininess(float value) {
-  glUniform1f(u_material_shininess, value);
+  print_uniform_locations();
+  return true;
 }
 
-void phong_shader::set_light_position(size_t index, const glm::vec3& v) {
-  if (index < u_num_lights) {
-    glUniform3f(u_light_positions + index, v.x, v.y, v.z);
-  }
+void phong_shader::bind() {
+  glUseProgram(m_program);
 }
 
-void phong_shader::set_num_lights(int n) {
-  glUniform1i(u_num_lights, n);
-  // glUniform1ui(u_num_lights, GLuint ui);
+void phong_shader::set_model_matrix(const glm::mat4& m) {
+  glUniformMatrix4fv(u_model_mat, 1, GL_FALSE, glm::value_ptr(m));
 }
 
 void phong_shader::print_uniform_locations() {
   std::cout << "u_model_mat: " << u_model_mat << "\n"
-            << "u_view_mat: " << u_view_mat << "\n"
-            << "u_proj_mat: " << u_proj_mat << "\n"
-            << "u_camera_pos: " << u_camera_pos << "\n"
-            << "u_ambient_prod: " << u_ambient_prod << "\n"
-            << "u_diffuse_prod: " << u_diffuse_prod << "\n"
-            << "u_specular_prod: " << u_specular_prod << "\n"
-            << "u_material_shininess: " << u_material_shininess << "\n"
-            << "u_light_positions: " << u_light_positions << "\n"
-            << "u_num_lights: " << u_num_lights << "\n"
-            << "u_diffuse_color: " << glGetUniformLocation(m_program, "u_diffuse_color")
-            << "\n";
+            << "frame_data: " << glGetUniformBlockIndex(m_program, "frame_data") << "\n"
+            << "material_table: "
+            << glGetUniformBlockIndex(m_program, "material_table") << "\n";
 }
 
 }  // namespace graphics::shader
@@ -4,64 +4,77 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <string>
 #include <vector>
 
+#include <shader/shader.hpp>
+#include <utils/instance_format.hpp>
+
 namespace graphics::shader {
 
-/* With point lighting. Does not render the lights themselves. */
+/* GLSL vertex shader of the phong program, which reads the instances and
+ * passes world space normal and position and the material index on. Its
+ * gl_Position is invariant, so programs sharing it produce equal depths. */
+extern const std::string phong_vert_src;
+
+/* GLSL declarations of the Blinn-Phong lighting, to be inserted after the
+ * frame_data block and, with CLUSTERED_LIGHTING, the light cluster
+ * declarations. Declares the globals diffuseColor and matShininess, to be set
+ * before calling vec3 shade(N, V, worldPos, fragCoord). */
+extern const std::string phong_lighting_src;
+
+/* With point lighting. Does not render the lights themselves. The vertex
+ * shader reads per-instance data in the given format, and camera and lights
+ * from the per-frame uniform block of shader::frame_uniforms. Every
+ * instance's diffuse color and shininess come from shader::material_table, so
+ * instances of different materials share a draw call. With clustered
+ * lighting, the lights come from shader::light_clusters instead and each
+ * fragment only shades the lights of its cluster. The program is compiled
+ * asynchronously and may only be used once ready returns true. */
 class phong_shader {
  public:
-  phong_shader();
+  explicit phong_shader(
+      utilities::instance_format format = utilities::instance_format::matrix,
+      bool clustered_lighting = false);
 
   ~phong_shader();
 
+  /* Polls the compilation without blocking and initializes the uniforms once
+   * the program has linked. */
+  bool ready();
+
+  /* Waits for the compilation, initializes the uniforms and returns whether
+   * the program linked. */
+  bool wait();
+
+  /* Whether compiling or linking the program failed. */
+  bool failed() const { return m_pending.status == program_status::failed; }
+
   /* bind must be called before the renderer's draw call */
   void bind();
 
-  /* bind must be called before calling setters */
+  GLuint program() const { return m_program; }
+
+  /* bind must be called before calling setters. Camera and lights are set
+   * through shader::frame_uniforms instead, which needs no bound program. */
 
   // setters for the vertex shader uniforms
   void set_model_matrices(const std::vector<glm::mat4>& matrices);
 
   void set_model_matrix(const glm::mat4& m);
 
-  void set_view_matrix(const glm::mat4& m);
-
-  void set_projection_matrix(const glm::mat4& m);
-
-  void set_camera_pos(const glm::vec3& pos);
-
-  // setters for the fragment shader uniforms
-  void set_ambient_product(const glm::vec3& v);
-
-  void set_diffuse_product(const glm::vec3& v);
-
-  void set_specular_product(const glm::vec3& v);
-
-  void set_material_shininess(float value);
-
-  void set_light_position(size_t index, const glm::vec3& v);
-
-  void set_num_lights(int n);
-
  private:
   // vertex uniforms
   GLint u_model_mat;  // TODO: put in buffer for instanced drawing
-  GLint u_view_mat;
-  GLint u_proj_mat;
-  GLint u_camera_pos;
-
-  // fragment uniforms
-  GLint u_ambient_prod;
-  GLint u_diffuse_prod;
-  GLint u_specular_prod;
-  GLint u_material_shininess;
-
-  GLint u_light_positions;
-  GLint u_num_lights;
 
   // shader program
   GLuint m_program;
+  async_program m_pending;
+  bool m_initialized = false;
+
+  /* Initializes the uniforms the first time it is called after linking, and
+   * returns whether the program has linked. */
+  bool initialize();
 
   void print_uniform_locations();
 };
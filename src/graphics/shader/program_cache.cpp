@@ -0,0 +1,174 @@
+#include "program_cache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace graphics::shader {
+
+// identifies cache files, and changes whenever their layout does
+constexpr uint32_t k_cache_magic = 0x50334231;  // "P3B1"
+
+/* Header in front of the binary in every cache file. */
+struct cache_header {
+  uint32_t magic;
+  GLenum format;
+  uint64_t key;
+};
+
+static std::filesystem::path s_directory;
+static bool s_enabled = false;
+static program_cache_stats s_stats;
+
+static uint64_t fnv1a(uint64_t hash, const char* s) {
+  for (; s != nullptr && *s != '\0'; ++s) {
+    hash = (hash ^ static_cast<unsigned char>(*s)) * 1099511628211ull;
+  }
+  // separator, so that moving text between strings changes the hash
+  return (hash ^ 0xffu) * 1099511628211ull;
+}
+
+static std::filesystem::path cache_path(uint64_t key) {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+  return s_directory / name;
+}
+
+/* Name of a temporary file next to path that no other writer uses: a random
+ * number drawn once per process, and a counter for the writes of the
+ * process. */
+static std::filesystem::path temporary_path(const std::filesystem::path& path) {
+  static const unsigned long long s_writer = [] {
+    std::random_device random;
+    return (static_cast<unsigned long long>(random()) << 32) ^ random();
+  }();
+  static unsigned long long s_count = 0;
+
+  char suffix[48];
+  snprintf(suffix, sizeof(suffix), ".%016llx.%llu.tmp", s_writer, s_count++);
+  auto temporary = path;
+  temporary += suffix;
+  return temporary;
+}
+
+void enable_program_cache(const std::string& directory) {
+  GLint n_formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+  if (n_formats == 0) {
+    std::cout << "Program cache disabled: no program binary formats.\n";
+    return;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error) {
+    std::cout << "Error: failed to create program cache directory " << directory
+              << ": " << error.message() << "\n";
+    return;
+  }
+
+  s_directory = directory;
+  s_enabled = true;
+}
+
+bool program_cache_enabled() {
+  return s_enabled;
+}
+
+uint64_t program_cache_key(const std::vector<const char*>& sources) {
+  uint64_t hash = 14695981039346656037ull;
+
+  for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+    hash = fnv1a(hash, reinterpret_cast<const char*>(glGetString(name)));
+  }
+  for (const char* source : sources) {
+    hash = fnv1a(hash, source);
+  }
+  return hash;
+}
+
+GLuint load_cached_program(uint64_t key) {
+  if (!s_enabled) {
+    return 0;
+  }
+
+  std::ifstream file(cache_path(key), std::ios::binary);
+  cache_header header{};
+  if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      header.magic != k_cache_magic || header.key != key) {
+    ++s_stats.misses;
+    return 0;
+  }
+
+  std::vector<char> binary{std::istreambuf_iterator<char>(file),
+                           std::istreambuf_iterator<char>()};
+
+  const GLuint program = glCreateProgram();
+  glProgramBinary(program, header.format, binary.data(), binary.size());
+
+  // drivers reject binaries of other versions at this point
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (linked == GL_FALSE) {
+    glDeleteProgram(program);
+    ++s_stats.misses;
+    return 0;
+  }
+
+  ++s_stats.hits;
+  return program;
+}
+
+void store_cached_program(uint64_t key, GLuint program) {
+  if (!s_enabled) {
+    return;
+  }
+
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (linked == GL_FALSE || length <= 0) {
+    return;
+  }
+
+  std::vector<char> binary(length);
+  cache_header header{k_cache_magic, 0, key};
+  glGetProgramBinary(program, length, &length, &header.format, binary.data());
+
+  // write to a temporary file of this writer first, so other processes never
+  // read a partial binary, even when they store the same program at once
+  const auto path = cache_path(key);
+  const auto temporary = temporary_path(path);
+
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), length);
+    if (!file) {
+      std::cout << "Error: failed to write program cache file " << temporary << "\n";
+      file.close();
+
+      std::error_code ignored;
+      std::filesystem::remove(temporary, ignored);
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error) {
+    std::cout << "Error: failed to store program cache file " << path << ": "
+              << error.message() << "\n";
+    std::filesystem::remove(temporary, error);
+  }
+}
+
+const program_cache_stats& get_program_cache_stats() {
+  return s_stats;
+}
+
+}  // namespace graphics::shader
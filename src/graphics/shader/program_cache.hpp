@@ -0,0 +1,45 @@
+#ifndef PROGRAM_CACHE_HPP
+#define PROGRAM_CACHE_HPP
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace graphics::shader {
+
+/* Enables the on-disk cache of linked program binaries in directory, which is
+ * created if needed. compile_program and compile_compute_program then load a
+ * program with glProgramBinary when a binary of the same sources made by the
+ * same driver exists, and fall back to compiling otherwise. Does nothing if
+ * the driver supports no binary formats. Requires a current context. */
+void enable_program_cache(const std::string& directory);
+
+/* Key of a program: a hash of its sources and the driver's vendor, renderer
+ * and version strings. */
+uint64_t program_cache_key(const std::vector<const char*>& sources);
+
+/* Returns the cached program for key, or 0 if the cache is disabled, has no
+ * binary for key or the driver rejects the binary. */
+GLuint load_cached_program(uint64_t key);
+
+/* Stores the binary of a linked program under key. Does nothing if the cache
+ * is disabled or the program failed to link. */
+void store_cached_program(uint64_t key, GLuint program);
+
+/* Whether programs should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT. */
+bool program_cache_enabled();
+
+/* Number of programs loaded from and missing in the cache. */
+struct program_cache_stats {
+  size_t hits = 0;
+  size_t misses = 0;
+};
+
+const program_cache_stats& get_program_cache_stats();
+
+}  // namespace graphics::shader
+
+#endif  // PROGRAM_CACHE_HPP
@@ -1,10 +1,13 @@
 #include "shader.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include <shader/program_cache.hpp>
+
 namespace graphics::shader {
 
 std::optional<std::string> get_shader_error(GLuint shader) {
@@ -24,30 +27,159 @@ std::optional<std::string> get_shader_error(GLuint shader) {
   return std::string(errorLog.data());
 }
 
-GLuint compile_program(const char* vert_src, const char* frag_src) {
-  const GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+static std::optional<std::string> get_program_error(GLuint program) {
+  GLint isLinked;
+  glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+
+  if (isLinked != GL_FALSE) {
+    return std::nullopt;
+  }
+
+  GLint maxLength;
+  glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
 
-  glShaderSource(vertex_shader, 1, &vert_src, NULL);
-  glCompileShader(vertex_shader);
+  std::vector<GLchar> errorLog(std::max(maxLength, 1));
+  glGetProgramInfoLog(program, errorLog.size(), &maxLength, errorLog.data());
+
+  return std::string(errorLog.data());
+}
+
+static const char* stage_name(GLenum type) {
+  switch (type) {
+    case GL_VERTEX_SHADER:
+      return "vertex";
+    case GL_FRAGMENT_SHADER:
+      return "fragment";
+    case GL_COMPUTE_SHADER:
+      return "compute";
+    default:
+      return "unknown";
+  }
+}
 
-  const GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fragment_shader, 1, &frag_src, NULL);
-  glCompileShader(fragment_shader);
+// whether the driver compiles on its own threads and reports completion
+static bool s_parallel_compile = false;
+
+void enable_parallel_compile() {
+  // let the driver pick the number of threads
+  const GLuint max_threads = 0xffffffffu;
+
+  if (GLAD_GL_KHR_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsKHR(max_threads);
+    s_parallel_compile = true;
+  } else if (GLAD_GL_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(max_threads);
+    s_parallel_compile = true;
+  }
+}
+
+/* Submits compilation of the stages and linking of the program without
+ * querying any status, so the driver need not finish before returning. */
+static async_program submit_program(const std::vector<GLenum>& types,
+                                    const std::vector<const char*>& sources) {
+  async_program result;
+  result.cache_key = program_cache_key(sources);
+
+  if (const GLuint cached = load_cached_program(result.cache_key)) {
+    result.program = cached;
+    result.status = program_status::linked;
+    return result;
+  }
+
+  result.program = glCreateProgram();
+  if (program_cache_enabled()) {
+    glProgramParameteri(result.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+
+  for (size_t i = 0; i < types.size(); ++i) {
+    const GLuint shader = glCreateShader(types[i]);
+    glShaderSource(shader, 1, &sources[i], NULL);
+    glCompileShader(shader);
+
+    glAttachShader(result.program, shader);
+    result.shaders.push_back(shader);
+  }
+
+  glLinkProgram(result.program);
+  return result;
+}
+
+async_program compile_program_async(const char* vert_src, const char* frag_src) {
+  return submit_program({GL_VERTEX_SHADER, GL_FRAGMENT_SHADER}, {vert_src, frag_src});
+}
+
+async_program compile_compute_program_async(const char* comp_src) {
+  return submit_program({GL_COMPUTE_SHADER}, {comp_src});
+}
+
+program_status poll_program(async_program& program) {
+  if (program.status != program_status::compiling) {
+    return program.status;
+  }
+
+  if (s_parallel_compile) {
+    GLint completed = GL_FALSE;
+    glGetProgramiv(program.program, GL_COMPLETION_STATUS_KHR, &completed);
+    if (completed == GL_FALSE) {
+      return program.status;
+    }
+  }
+
+  return finish_program(program);
+}
+
+program_status finish_program(async_program& program) {
+  if (program.status != program_status::compiling) {
+    return program.status;
+  }
 
   // OpenGL error checks
-  if (auto vert_error = get_shader_error(vertex_shader)) {
-    std::cout << "vertex shader error: " << *vert_error << "\n";
+  for (GLuint shader : program.shaders) {
+    if (auto error = get_shader_error(shader)) {
+      GLint type;
+      glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+      std::cout << stage_name(type) << " shader error: " << *error << "\n";
+    }
+  }
+
+  if (auto error = get_program_error(program.program)) {
+    std::cout << "program link error: " << *error << "\n";
+    program.status = program_status::failed;
+  } else {
+    store_cached_program(program.cache_key, program.program);
+    program.status = program_status::linked;
   }
-  if (auto frag_error = get_shader_error(fragment_shader)) {
-    std::cout << "fragment shader error: " << *frag_error << "\n";
+
+  // the linked program keeps working without its shaders
+  for (GLuint shader : program.shaders) {
+    glDetachShader(program.program, shader);
+    glDeleteShader(shader);
   }
+  program.shaders.clear();
+
+  return program.status;
+}
 
-  const GLuint program = glCreateProgram();
-  glAttachShader(program, vertex_shader);
-  glAttachShader(program, fragment_shader);
-  glLinkProgram(program);
+GLuint compile_program(const char* vert_src, const char* frag_src) {
+  auto program = compile_program_async(vert_src, frag_src);
+  finish_program(program);
+  return program.program;
+}
+
+GLuint compile_compute_program(const char* comp_src) {
+  auto program = compile_compute_program_async(comp_src);
+  finish_program(program);
+  return program.program;
+}
+
+std::string with_defines(const std::string& src, const std::string& defines) {
+  const size_t version = src.find("#version");
+  const size_t line_end = src.find('\n', version);
+  if (version == std::string::npos || line_end == std::string::npos) {
+    return src;
+  }
 
-  return program;
+  return src.substr(0, line_end + 1) + defines + src.substr(line_end + 1);
 }
 
 static const char* vertex_shader_text =
@@ -3,12 +3,57 @@
 
 #include <glad/glad.h>
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 namespace graphics::shader {
 
 /* Compile and return program from vertex and fragments shader sources. Prints
- * error if compilation fails. */
+ * error if compilation fails. Loads the program from the program cache instead
+ * if it is enabled and holds a binary of the sources. */
 GLuint compile_program(const char* vert_src, const char* frag_src);
 
+/* Compile and return program from compute shader source. Prints error if
+ * compilation fails. Uses the program cache like compile_program. Requires
+ * OpenGL 4.3. */
+GLuint compile_compute_program(const char* comp_src);
+
+enum class program_status { compiling, linked, failed };
+
+/* Program whose compilation and linking was submitted to the driver without
+ * waiting for it. */
+struct async_program {
+  GLuint program = 0;
+  std::vector<GLuint> shaders;
+  uint64_t cache_key = 0;
+  program_status status = program_status::compiling;
+};
+
+/* Lets the driver compile on its own threads if GL_KHR_parallel_shader_compile
+ * or GL_ARB_parallel_shader_compile is available, which makes poll_program
+ * non-blocking. Requires a current context. */
+void enable_parallel_compile();
+
+/* Submits compilation and linking of the program and returns right away. The
+ * program must not be used before poll_program or finish_program reports it
+ * as linked. Uses the program cache like compile_program. */
+async_program compile_program_async(const char* vert_src, const char* frag_src);
+
+async_program compile_compute_program_async(const char* comp_src);
+
+/* Returns the program's status. Once the driver is done, checks compile and
+ * link status, prints errors and releases the shaders. Without parallel
+ * compilation, this waits for the driver like finish_program. */
+program_status poll_program(async_program& program);
+
+/* Waits for the driver to finish the program and returns its status. */
+program_status finish_program(async_program& program);
+
+/* Returns the source with the preprocessor definitions inserted right after
+ * its #version directive. */
+std::string with_defines(const std::string& src, const std::string& defines);
+
 
 } // namespace graphics::shader
 
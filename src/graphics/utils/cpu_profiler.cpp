@@ -0,0 +1,95 @@
+#include "cpu_profiler.hpp"
+
+#include <iostream>
+
+namespace graphics::utilities {
+
+cpu_profiler::cpu_profiler(size_t window_size) : m_window_size(window_size) {}
+
+bool cpu_profiler::open_csv(const std::string& path) {
+  m_csv.open(path);
+  if (!m_csv) {
+    std::cout << "Error: cannot write " << path << "\n";
+    return false;
+  }
+
+  m_csv << "frame,scope,ms\n";
+  return true;
+}
+
+void cpu_profiler::close_csv() {
+  m_csv.close();
+}
+
+void cpu_profiler::begin_frame() {
+  begin("frame");
+}
+
+void cpu_profiler::end_frame() {
+  // close scopes left open, including the frame itself
+  while (!m_open.empty()) {
+    end();
+  }
+
+  for (size_t i = 0; i < m_frame_ms.size(); ++i) {
+    if (m_frame_ms[i] < 0.0) {
+      continue;
+    }
+
+    m_windows[i].add(m_frame_ms[i]);
+    if (m_csv.is_open()) {
+      m_csv << m_frame << ',' << m_names[i] << ',' << m_frame_ms[i] << '\n';
+    }
+
+    m_frame_ms[i] = -1.0;
+  }
+
+  ++m_frame;
+}
+
+void cpu_profiler::begin(const std::string& name) {
+  auto [it, inserted] = m_scope_indices.try_emplace(name, m_names.size());
+  if (inserted) {
+    m_names.push_back(name);
+    m_windows.emplace_back(m_window_size);
+    m_frame_ms.push_back(-1.0);
+  }
+
+  m_open.push_back({it->second, clock::now()});
+}
+
+void cpu_profiler::end() {
+  const auto now = clock::now();
+
+  if (m_open.empty()) {
+    std::cout << "Error: cpu_profiler::end without begin\n";
+    return;
+  }
+
+  const auto scope = m_open.back();
+  m_open.pop_back();
+
+  const double ms = std::chrono::duration<double, std::milli>(now - scope.start).count();
+  double& total = m_frame_ms[scope.scope];
+  total = total < 0.0 ? ms : total + ms;
+}
+
+timing_stats cpu_profiler::stats(const std::string& name) const {
+  const auto it = m_scope_indices.find(name);
+  if (it == m_scope_indices.end()) {
+    return {};
+  }
+
+  return m_windows[it->second].stats();
+}
+
+void cpu_profiler::print() const {
+  for (size_t i = 0; i < m_names.size(); ++i) {
+    const auto s = m_windows[i].stats();
+    std::cout << "CPU " << m_names[i] << ": mean " << s.mean << " ms, p50 " << s.p50
+              << " ms, p95 " << s.p95 << " ms, p99 " << s.p99 << " ms, max " << s.max
+              << " ms over " << s.samples << " frames\n";
+  }
+}
+
+}  // namespace graphics::utilities
@@ -0,0 +1,70 @@
+#ifndef CPU_PROFILER_HPP
+#define CPU_PROFILER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/timing_window.hpp>
+
+namespace graphics::utilities {
+
+/* Measures the CPU time of named scopes with std::chrono::steady_clock. A scope
+ * entered several times in a frame counts once with its total time. Scopes may
+ * nest, and every frame is also measured as a whole under the name "frame".
+ * Optionally writes one CSV row per scope and frame. */
+class cpu_profiler {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /* Statistics are kept over the last window_size frames of every scope. */
+  explicit cpu_profiler(size_t window_size = 120);
+
+  /* Writes the rows "frame,scope,ms" of all following frames to path. */
+  bool open_csv(const std::string& path);
+
+  /* Flushes and closes the CSV file. */
+  void close_csv();
+
+  void begin_frame();
+
+  /* Adds the frame's scope times to their windows and the CSV file. */
+  void end_frame();
+
+  void begin(const std::string& name);
+
+  /* Ends the innermost scope. */
+  void end();
+
+  /* Names of the measured scopes, in the order they were first begun. */
+  const std::vector<std::string>& scopes() const { return m_names; }
+
+  timing_stats stats(const std::string& name) const;
+
+  void print() const;
+
+ private:
+  struct open_scope {
+    size_t scope;
+    clock::time_point start;
+  };
+
+  std::vector<std::string> m_names;
+  std::unordered_map<std::string, size_t> m_scope_indices;
+  std::vector<timing_window> m_windows;
+  size_t m_window_size;
+
+  // time of every scope in the current frame, negative if not entered
+  std::vector<double> m_frame_ms;
+  std::vector<open_scope> m_open;
+  size_t m_frame = 0;
+
+  std::ofstream m_csv;
+};
+
+}  // namespace graphics::utilities
+
+#endif  // CPU_PROFILER_HPP
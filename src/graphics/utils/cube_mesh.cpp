@@ -1,9 +1,15 @@
 #include "cube_mesh.hpp"
 
 #include <glm/ext.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <iterator>
+#include <utility>
+
+#include <utils/mesh_builder.hpp>
 
 using point4 = glm::vec4;
 
@@ -14,63 +20,63 @@ struct vertex_data {
   std::vector<float> v_normals;
   std::vector<float> v_tex_coords;
 
-  vertex_data(size_t n_vertices) {
-    v_positions.reserve(4 * n_vertices);
-    v_normals.reserve(3 * n_vertices);
-    v_tex_coords.reserve(2 * n_vertices);
-  }
+  vertex_data(const std::vector<vertex>& vertices) {
+    v_positions.reserve(4 * vertices.size());
+    v_normals.reserve(3 * vertices.size());
+    v_tex_coords.reserve(2 * vertices.size());
+
+    for (const auto& v : vertices) {
+      v_positions.push_back(v.position.x);
+      v_positions.push_back(v.position.y);
+      v_positions.push_back(v.position.z);
+      v_positions.push_back(v.position.w);
 
-  void append_quad(const point4* vertices, int a, int b, int c, int d) {
-    // Initialize temporary vectors along the quad's edge to
-    // compute its face normal
-    glm::vec3 u(vertices[b] - vertices[a]);
-    glm::vec3 v(vertices[c] - vertices[b]);
-    glm::vec3 normal = glm::normalize(glm::cross(u, v));
-
-    const glm::vec2 coords[] = {
-        glm::vec2(0.0, 0.0), glm::vec2(0.0, 1.0), glm::vec2(1.0, 1.0),
-        glm::vec2(0.0, 0.0), glm::vec2(1.0, 1.0), glm::vec2(1.0, 0.0),
-    };
-
-    const point4 vert[] = {
-        vertices[a], vertices[b], vertices[c], vertices[a], vertices[c], vertices[d],
-    };
-
-    for (int i = 0; i < 6; ++i) {
-      v_positions.push_back(vert[i].x);
-      v_positions.push_back(vert[i].y);
-      v_positions.push_back(vert[i].z);
-      v_positions.push_back(vert[i].w);
-
-      v_normals.push_back(normal.x);
-      v_normals.push_back(normal.y);
-      v_normals.push_back(normal.z);
-
-      v_tex_coords.push_back(coords[i].x);
-      v_tex_coords.push_back(coords[i].y);
+      v_normals.push_back(v.normal.x);
+      v_normals.push_back(v.normal.y);
+      v_normals.push_back(v.normal.z);
+
+      v_tex_coords.push_back(v.tex_coord.x);
+      v_tex_coords.push_back(v.tex_coord.y);
     }
   }
 };
 
-constexpr size_t k_max_instances = 1000;
+static packed_vertex pack_vertex(const vertex& v) {
+  packed_vertex p;
+  p.position[0] = v.position.x;
+  p.position[1] = v.position.y;
+  p.position[2] = v.position.z;
+  // x in the lowest 10 bits, as GL_INT_2_10_10_10_REV expects
+  p.normal = glm::packSnorm3x10_1x2(glm::vec4(v.normal, 0.f));
+  p.tex_coord[0] = glm::packHalf1x16(v.tex_coord.x);
+  p.tex_coord[1] = glm::packHalf1x16(v.tex_coord.y);
+  return p;
+}
+
+// initial number of instances per frame; the buffer grows as needed
+constexpr size_t k_initial_instances = 1024;
+
+// corner indices of the cube's faces, counter-clockwise seen from outside
+constexpr int k_cube_faces[6][4] = {{1, 0, 3, 2}, {2, 3, 7, 6}, {3, 0, 4, 7},
+                                    {6, 5, 1, 2}, {4, 5, 6, 7}, {5, 4, 0, 1}};
 
-mesh_data make_cube_mesh_arrays(float width, float height, float depth) {
+static void make_cube_corners(float width, float height, float depth, point4* corners) {
   float hW = width / 2;
   float hH = height / 2;
   float hD = depth / 2;
 
-  point4 vertices[] = {point4(-hW, -hH, hD, 1.0),  point4(-hW, hH, hD, 1.0),
-                       point4(hW, hH, hD, 1.0),    point4(hW, -hH, hD, 1.0),
-                       point4(-hW, -hH, -hD, 1.0), point4(-hW, hH, -hD, 1.0),
-                       point4(hW, hH, -hD, 1.0),   point4(hW, -hH, -hD, 1.0)};
+  const point4 vertices[] = {point4(-hW, -hH, hD, 1.0),  point4(-hW, hH, hD, 1.0),
+                             point4(hW, hH, hD, 1.0),    point4(hW, -hH, hD, 1.0),
+                             point4(-hW, -hH, -hD, 1.0), point4(-hW, hH, -hD, 1.0),
+                             point4(hW, hH, -hD, 1.0),   point4(hW, -hH, -hD, 1.0)};
 
-  vertex_data data(36);
-  data.append_quad(vertices, 1, 0, 3, 2);
-  data.append_quad(vertices, 2, 3, 7, 6);
-  data.append_quad(vertices, 3, 0, 4, 7);
-  data.append_quad(vertices, 6, 5, 1, 2);
-  data.append_quad(vertices, 4, 5, 6, 7);
-  data.append_quad(vertices, 5, 4, 0, 1);
+  std::copy(std::begin(vertices), std::end(vertices), corners);
+}
+
+/* Uploads the separate position, normal and texture coordinate arrays and
+ * sets up their attributes in the bound vertex array. */
+static void upload_separate(const std::vector<vertex>& vertices) {
+  const vertex_data data(vertices);
 
   // set up vertex buffer object for vertex positions, normals, and texture
   // coordinates
@@ -83,9 +89,9 @@ mesh_data make_cube_mesh_arrays(float width, float height, float depth) {
   GLuint size_tex_coords = data.v_tex_coords.size() * sizeof(float);
   GLuint data_size = size_vertices + size_normals + size_tex_coords;
 
-  GLuint offset_vertices = 0;
-  GLuint offset_normals = size_vertices;
-  GLuint offset_tex_coords = size_vertices + size_normals;
+  size_t offset_vertices = 0;
+  size_t offset_normals = size_vertices;
+  size_t offset_tex_coords = size_vertices + size_normals;
 
   glBufferData(GL_ARRAY_BUFFER, data_size, NULL, GL_STATIC_DRAW);
   glBufferSubData(GL_ARRAY_BUFFER, offset_vertices, size_vertices,
@@ -94,21 +100,6 @@ mesh_data make_cube_mesh_arrays(float width, float height, float depth) {
   glBufferSubData(GL_ARRAY_BUFFER, offset_tex_coords, size_tex_coords,
                   data.v_tex_coords.data());
 
-  // buffer for instanced drawing with model matrices
-  GLuint model_matrix_buffer;
-  glGenBuffers(1, &model_matrix_buffer);
-  glBindBuffer(GL_ARRAY_BUFFER, model_matrix_buffer);
-  glBufferData(GL_ARRAY_BUFFER, 16 * sizeof(float) * k_max_instances, NULL,
-               GL_STATIC_DRAW);
-
-  // set up vertex array object
-  GLuint vao;
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
-
-  // setup the attributes of the vertex buffer
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
   // positions
   glEnableVertexAttribArray(0);
   glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (void*)(offset_vertices));
@@ -120,45 +111,182 @@ mesh_data make_cube_mesh_arrays(float width, float height, float depth) {
   // texture coordinates
   glEnableVertexAttribArray(2);
   glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (void*)(offset_tex_coords));
+}
 
-  // setup the attributes of the model-matrix buffer
-  // TODO: consider using a uniform buffer or shader storage buffer instead
-  glBindBuffer(GL_ARRAY_BUFFER, model_matrix_buffer);
+/* Uploads the vertices interleaved and packed and sets up their attributes in
+ * the bound vertex array. */
+static void upload_packed(const std::vector<vertex>& vertices) {
+  std::vector<packed_vertex> data;
+  data.reserve(vertices.size());
+  std::transform(vertices.begin(), vertices.end(), std::back_inserter(data),
+                 pack_vertex);
 
+  GLuint vbo;
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(packed_vertex), data.data(),
+               GL_STATIC_DRAW);
+
+  const GLsizei stride = sizeof(packed_vertex);
+
+  // positions, w defaults to 1
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+                        (void*)offsetof(packed_vertex, position));
+
+  // normals, normalized from signed 10-bit integers
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                        (void*)offsetof(packed_vertex, normal));
+
+  // texture coordinates
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+                        (void*)offsetof(packed_vertex, tex_coord));
+}
+
+/* Uploads the vertices in the given format and sets up a vertex array object
+ * reading them, with the instance attributes of instances attached. Leaves the
+ * vertex array bound. */
+static GLuint make_vertex_array(const std::vector<vertex>& vertices,
+                                vertex_format format,
+                                instance_buffer& instances) {
+  // set up vertex array object
+  GLuint vao;
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+
+  if (format == vertex_format::packed) {
+    upload_packed(vertices);
+  } else {
+    upload_separate(vertices);
+  }
+
+  // setup the attributes of the model-matrix buffer, which occupy locations 3-6
+  // for matrices and 3-4 for compact instances
+  // TODO: consider using a uniform buffer or shader storage buffer instead
   size_t model_matrix_location = 3;
-  for (size_t i = 0; i < 4; ++i) {
-    glEnableVertexAttribArray(model_matrix_location + i);
-    glVertexAttribPointer(model_matrix_location + i, 4, GL_FLOAT, GL_FALSE, 64,
-                          (void*)(i * 16));
-    glVertexAttribDivisor(model_matrix_location + i,
-                          1);  // for instanced drawing
+  instances.attach(vao, model_matrix_location);
+
+  glBindVertexArray(vao);
+  return vao;
+}
+
+mesh_data make_cube_mesh_arrays(float width,
+                                float height,
+                                float depth,
+                                instance_format format,
+                                vertex_format v_format) {
+  // expand the indexed cube into a plain triangle list
+  const indexed_mesh cube = make_cube_indexed_mesh(width, height, depth);
+
+  std::vector<vertex> vertices;
+  vertices.reserve(cube.indices.size());
+  for (GLuint index : cube.indices) {
+    vertices.push_back(cube.vertices[index]);
   }
 
-  return mesh_data{vao, model_matrix_buffer};
+  // ring buffer for instanced drawing with model matrices or compact transforms
+  instance_buffer model_matrix_buffer(k_initial_instances, instance_size(format));
+
+  GLuint vao = make_vertex_array(vertices, v_format, model_matrix_buffer);
+
+  const auto count = static_cast<GLsizei>(vertices.size());
+  return mesh_data{vao, std::move(model_matrix_buffer), count, false};
 }
 
-GLint make_cube_mesh_elements() {
-  return 0;
+indexed_mesh make_cube_indexed_mesh(float width, float height, float depth) {
+  point4 corners[8];
+  make_cube_corners(width, height, depth, corners);
+
+  mesh_builder builder;
+  for (const auto& face : k_cube_faces) {
+    const point4& a = corners[face[0]];
+    const point4& b = corners[face[1]];
+    const point4& c = corners[face[2]];
+    const point4& d = corners[face[3]];
+
+    glm::vec3 normal =
+        glm::normalize(glm::cross(glm::vec3(b - a), glm::vec3(c - b)));
+
+    builder.add_quad(vertex{a, normal, glm::vec2(0.0, 0.0)},
+                     vertex{b, normal, glm::vec2(0.0, 1.0)},
+                     vertex{c, normal, glm::vec2(1.0, 1.0)},
+                     vertex{d, normal, glm::vec2(1.0, 0.0)});
+  }
+
+  return builder.build();
 }
 
-void update_matrix_buffer(GLuint buffer, std::vector<glm::mat4>& matrices) {
-  size_t len = matrices.size();
-  size_t stride = 16;
+mesh_data make_mesh_elements(const indexed_mesh& mesh,
+                             instance_format format,
+                             vertex_format v_format) {
+  instance_buffer model_matrix_buffer(k_initial_instances, instance_size(format));
 
-  if (len > k_max_instances) {
-    std::cout << "Error: too many model matrices for array buffer.";
-    return;
+  GLuint vao = make_vertex_array(mesh.vertices, v_format, model_matrix_buffer);
+
+  // the element buffer binding is part of the vertex array's state
+  GLuint ebo;
+  glGenBuffers(1, &ebo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(GLuint),
+               mesh.indices.data(), GL_STATIC_DRAW);
+
+  const auto count = static_cast<GLsizei>(mesh.indices.size());
+  return mesh_data{vao, std::move(model_matrix_buffer), count, true};
+}
+
+mesh_data make_shared_mesh_elements(const std::vector<indexed_mesh>& meshes,
+                                    std::vector<submesh>& submeshes,
+                                    instance_format format,
+                                    vertex_format v_format) {
+  // the indices stay relative to their mesh, the draws add the base vertex
+  indexed_mesh shared;
+  for (const auto& mesh : meshes) {
+    submeshes.push_back(submesh{static_cast<GLsizei>(mesh.indices.size()),
+                                static_cast<GLuint>(shared.indices.size()),
+                                static_cast<GLint>(shared.vertices.size())});
+
+    shared.vertices.insert(shared.vertices.end(), mesh.vertices.begin(),
+                           mesh.vertices.end());
+    shared.indices.insert(shared.indices.end(), mesh.indices.begin(),
+                          mesh.indices.end());
   }
 
-  // update scatter position data
-  glBindBuffer(GL_ARRAY_BUFFER, buffer);
-  auto p_data =
-      (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, stride * sizeof(float) * len,
-                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  return make_mesh_elements(shared, format, v_format);
+}
+
+mesh_data make_cube_mesh_elements(float width,
+                                  float height,
+                                  float depth,
+                                  instance_format format,
+                                  vertex_format v_format) {
+  return make_mesh_elements(make_cube_indexed_mesh(width, height, depth), format,
+                            v_format);
+}
+
+void draw_instances(const mesh_data& mesh, GLsizei n_instances) {
+  glBindVertexArray(mesh.vertex_array_object);
+
+  const GLuint base_instance = mesh.matrix_buffer.base_instance();
+  if (mesh.indexed) {
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, mesh.count, GL_UNSIGNED_INT,
+                                        nullptr, n_instances, base_instance);
+  } else {
+    glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, mesh.count, n_instances,
+                                      base_instance);
+  }
+}
+
+void update_matrix_buffer(instance_buffer& buffer,
+                          const std::vector<glm::mat4>& matrices) {
+  size_t len = matrices.size();
+  size_t stride = 16;
+
+  auto p_data = (float*)buffer.map_region(len);
 
   if (p_data == nullptr) {
     std::cout << "Erros: failed to map position data.\n";
-    glUnmapBuffer(GL_ARRAY_BUFFER);  // unmap buffer necessary?
     return;
   }
 
@@ -172,7 +300,21 @@ void update_matrix_buffer(GLuint buffer, std::vector<glm::mat4>& matrices) {
     offset += stride;
   }
 
-  glUnmapBuffer(GL_ARRAY_BUFFER);
+  buffer.unmap_region();
+}
+
+void update_instance_buffer(instance_buffer& buffer,
+                            const std::vector<compact_instance>& instances) {
+  auto p_data = (compact_instance*)buffer.map_region(instances.size());
+
+  if (p_data == nullptr) {
+    std::cout << "Error: failed to map instance data.\n";
+    return;
+  }
+
+  std::copy(instances.begin(), instances.end(), p_data);
+
+  buffer.unmap_region();
 }
 
 }  // namespace graphics::utilities
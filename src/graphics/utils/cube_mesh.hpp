@@ -6,25 +6,75 @@
 
 #include <vector>
 
+#include <utils/instance_buffer.hpp>
+#include <utils/instance_format.hpp>
+#include <utils/mesh_builder.hpp>
+#include <utils/vertex_format.hpp>
 
 namespace graphics::utilities {
 
 struct mesh_data {
     GLuint vertex_array_object;
-    GLuint matrix_buffer_object;
+    instance_buffer matrix_buffer;
+    // number of vertices, or of indices if indexed
+    GLsizei count;
+    bool indexed;
 };
 
 /* Generates a cube mesh with vertex positions, normals, and texture
- * coordinates intended to be used with glDrawArrays. */
-mesh_data make_cube_mesh_arrays(float width, float height, float depth);
+ * coordinates intended to be used with glDrawArrays. The vertices are stored
+ * in v_format and the instance buffer holds instances of the given format. */
+mesh_data make_cube_mesh_arrays(float width,
+                                float height,
+                                float depth,
+                                instance_format format = instance_format::matrix,
+                                vertex_format v_format = vertex_format::separate);
 
 /* Generates a cube mesh with vertex positions, normals, and texture
- * coordinates intended to be used with glDrawElements. */
-GLint make_cube_mesh_elements();
+ * coordinates intended to be used with glDrawElements. The 24 unique vertices
+ * are shared by the 36 indices. */
+mesh_data make_cube_mesh_elements(float width,
+                                  float height,
+                                  float depth,
+                                  instance_format format = instance_format::matrix,
+                                  vertex_format v_format = vertex_format::separate);
 
-/* Overwrites the array buffer's data with matrices. Starts writing from the
- * beginning of the buffer. */
-void update_matrix_buffer(GLuint buffer, std::vector<glm::mat4>& matrices);
+/* The cube's unique vertices and triangle indices, before upload. */
+indexed_mesh make_cube_indexed_mesh(float width, float height, float depth);
+
+/* Uploads an indexed mesh intended to be used with glDrawElements. */
+mesh_data make_mesh_elements(const indexed_mesh& mesh,
+                             instance_format format = instance_format::matrix,
+                             vertex_format v_format = vertex_format::separate);
+
+/* Index range of one mesh inside shared vertex and index buffers. */
+struct submesh {
+  GLsizei count;
+  GLuint first_index;
+  GLint base_vertex;
+};
+
+/* Uploads several indexed meshes into one vertex array with shared vertex and
+ * index buffers, e.g. the levels of detail of a shape, so they are drawn
+ * without switching vertex arrays. The range of every mesh is appended to
+ * submeshes in order; the returned mesh's count covers all indices. */
+mesh_data make_shared_mesh_elements(const std::vector<indexed_mesh>& meshes,
+                                    std::vector<submesh>& submeshes,
+                                    instance_format format = instance_format::matrix,
+                                    vertex_format v_format = vertex_format::separate);
+
+/* Draws n_instances instances of the mesh, reading them from the current
+ * region of its instance buffer. */
+void draw_instances(const mesh_data& mesh, GLsizei n_instances);
+
+/* Writes matrices into the next region of the instance buffer, growing it if
+ * needed. The region must be fenced with instance_buffer::fence_region after
+ * the draw call reading it, which has to use the buffer's base instance. */
+void update_matrix_buffer(instance_buffer& buffer, const std::vector<glm::mat4>& matrices);
+
+/* Same as update_matrix_buffer, for buffers of instance_format::compact. */
+void update_instance_buffer(instance_buffer& buffer,
+                            const std::vector<compact_instance>& instances);
 
 } // namespace graphics::utilities
 
@@ -0,0 +1,49 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace graphics::utilities {
+
+frame_arena::frame_arena(size_t capacity)
+    : m_buffer(std::make_unique<std::byte[]>(capacity)), m_capacity(capacity) {}
+
+void* frame_arena::allocate(size_t size, size_t alignment) {
+  const auto base = reinterpret_cast<uintptr_t>(m_buffer.get());
+  const uintptr_t aligned = (base + m_offset + alignment - 1) & ~(alignment - 1);
+  const size_t end = aligned - base + size;
+
+  if (end <= m_capacity) {
+    m_used += end - m_offset;
+    m_offset = end;
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  // too large for the rest of the frame, served by the heap until reset grows
+  // the arena
+  auto block = std::make_unique<std::byte[]>(size + alignment);
+  const auto block_base = reinterpret_cast<uintptr_t>(block.get());
+  const uintptr_t block_aligned = (block_base + alignment - 1) & ~(alignment - 1);
+
+  m_overflow_blocks.push_back(std::move(block));
+  m_used += size + alignment;
+  ++m_overflows;
+
+  return reinterpret_cast<void*>(block_aligned);
+}
+
+void frame_arena::reset() {
+  m_high_water = std::max(m_high_water, m_used);
+
+  if (!m_overflow_blocks.empty()) {
+    m_overflow_blocks.clear();
+
+    m_capacity = m_high_water;
+    m_buffer = std::make_unique<std::byte[]>(m_capacity);
+  }
+
+  m_offset = 0;
+  m_used = 0;
+}
+
+}  // namespace graphics::utilities
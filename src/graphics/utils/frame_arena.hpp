@@ -0,0 +1,102 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace graphics::utilities {
+
+/* Bump allocator for data that lives for one frame, such as instance lists,
+ * cull results and sort keys. Allocating only advances an offset, nothing is
+ * freed individually, and reset releases everything at the end of the frame.
+ *
+ * When a frame needs more than the capacity, the excess is served from
+ * separate heap blocks, and the next reset grows the arena to the frame's
+ * high-water mark, so steady-state frames make no heap allocations. */
+class frame_arena {
+ public:
+  explicit frame_arena(size_t capacity = size_t{1} << 20);
+
+  frame_arena(const frame_arena&) = delete;
+  frame_arena& operator=(const frame_arena&) = delete;
+
+  /* Returns uninitialized memory that stays valid until reset. */
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /* Uninitialized array of n objects, which must not need destruction. */
+  template <class T>
+  T* allocate_array(size_t n) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+  }
+
+  /* Releases all allocations of the frame. */
+  void reset();
+
+  /* Bytes allocated in the current frame. */
+  size_t used() const { return m_used; }
+
+  size_t capacity() const { return m_capacity; }
+
+  /* Most bytes ever allocated in one frame. */
+  size_t high_water() const { return m_high_water; }
+
+  /* Number of heap allocations made because a frame exceeded the capacity. */
+  size_t overflows() const { return m_overflows; }
+
+ private:
+  std::unique_ptr<std::byte[]> m_buffer;
+  size_t m_capacity;
+  size_t m_offset = 0;
+
+  std::vector<std::unique_ptr<std::byte[]>> m_overflow_blocks;
+
+  size_t m_used = 0;
+  size_t m_high_water = 0;
+  size_t m_overflows = 0;
+};
+
+/* Standard allocator on a frame_arena, for containers that live for one
+ * frame. Deallocation does nothing, so containers should reserve their final
+ * size up front instead of growing. */
+template <class T>
+class arena_allocator {
+ public:
+  using value_type = T;
+
+  explicit arena_allocator(frame_arena& arena) : m_arena(&arena) {}
+
+  template <class U>
+  arena_allocator(const arena_allocator<U>& other) : m_arena(other.arena()) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T*, size_t) {}
+
+  frame_arena* arena() const { return m_arena; }
+
+  template <class U>
+  bool operator==(const arena_allocator<U>& other) const {
+    return m_arena == other.arena();
+  }
+
+  template <class U>
+  bool operator!=(const arena_allocator<U>& other) const {
+    return m_arena != other.arena();
+  }
+
+ private:
+  frame_arena* m_arena;
+};
+
+template <class T>
+using frame_vector = std::vector<T, arena_allocator<T>>;
+
+}  // namespace graphics::utilities
+
+#endif  // FRAME_ARENA_HPP
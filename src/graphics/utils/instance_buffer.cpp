@@ -0,0 +1,197 @@
+#include "instance_buffer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace graphics::utilities {
+
+// one second, in nanoseconds
+constexpr GLuint64 k_fence_timeout = 1000000000;
+
+constexpr size_t k_attribute_size = 4 * sizeof(float);
+
+void specify_instance_attributes(GLuint vao,
+                                 GLuint location,
+                                 GLuint buffer,
+                                 size_t instance_size) {
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+  const size_t n_attributes = instance_size / k_attribute_size;
+  for (size_t i = 0; i < n_attributes; ++i) {
+    glEnableVertexAttribArray(location + i);
+    glVertexAttribPointer(location + i, 4, GL_FLOAT, GL_FALSE, instance_size,
+                          (void*)(i * k_attribute_size));
+    glVertexAttribDivisor(location + i, 1);  // for instanced drawing
+  }
+}
+
+instance_buffer::instance_buffer(size_t capacity, size_t instance_size)
+    : m_instance_size(instance_size) {
+  m_persistent = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+  allocate(std::max<size_t>(capacity, 1));
+}
+
+instance_buffer::~instance_buffer() {
+  release();
+}
+
+instance_buffer::instance_buffer(instance_buffer&& other) noexcept {
+  *this = std::move(other);
+}
+
+instance_buffer& instance_buffer::operator=(instance_buffer&& other) noexcept {
+  if (this != &other) {
+    release();
+
+    m_buffer = std::exchange(other.m_buffer, 0);
+    m_capacity = other.m_capacity;
+    m_instance_size = other.m_instance_size;
+    m_reallocations = other.m_reallocations;
+    m_attachments = std::move(other.m_attachments);
+    m_region = other.m_region;
+    m_fences = std::exchange(other.m_fences, {});
+    m_data = std::exchange(other.m_data, nullptr);
+    m_persistent = other.m_persistent;
+  }
+  return *this;
+}
+
+void instance_buffer::attach(GLuint vao, GLuint location) {
+  m_attachments.push_back({vao, location});
+  specify_instance_attributes(vao, location, m_buffer, m_instance_size);
+}
+
+void instance_buffer::detach(GLuint vao) {
+  m_attachments.erase(std::remove_if(m_attachments.begin(), m_attachments.end(),
+                                     [vao](const attachment& a) { return a.vao == vao; }),
+                      m_attachments.end());
+}
+
+void* instance_buffer::map_region(size_t count) {
+  if (count > m_capacity) {
+    grow(count);
+  }
+
+  m_region = (m_region + 1) % k_num_regions;
+  wait_for_fence(m_region);
+
+  const size_t offset = m_region * region_size();
+
+  if (m_persistent) {
+    return m_data != nullptr ? m_data + offset : nullptr;
+  }
+
+  // without buffer storage, map only the region; the fence already guarantees
+  // that the GPU is done with it so the driver need not synchronize
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+  m_data = (char*)glMapBufferRange(
+      GL_ARRAY_BUFFER, offset, region_size(),
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+  if (m_data == nullptr) {
+    std::cout << "Error: failed to map instance buffer region.\n";
+  }
+  return m_data;
+}
+
+void instance_buffer::unmap_region() {
+  if (m_persistent || m_data == nullptr) {
+    // coherent mapping, writes are visible to the GPU as is
+    return;
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+  m_data = nullptr;
+}
+
+void instance_buffer::fence_region() {
+  if (m_fences[m_region] != nullptr) {
+    glDeleteSync(m_fences[m_region]);
+  }
+  m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void instance_buffer::allocate(size_t capacity) {
+  m_capacity = capacity;
+  const GLsizeiptr size = k_num_regions * region_size();
+
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+  if (m_persistent) {
+    const GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+    m_data = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+
+    if (m_data == nullptr) {
+      std::cout << "Error: failed to persistently map instance buffer.\n";
+    }
+  } else {
+    glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+  }
+}
+
+void instance_buffer::grow(size_t count) {
+  size_t capacity = m_capacity;
+  while (capacity < count) {
+    capacity *= 2;
+  }
+
+  // the old buffer may still be read by draws in flight; deleting it only
+  // drops our reference and the driver frees it once those draws complete
+  auto attachments = std::move(m_attachments);
+  release();
+  allocate(capacity);
+
+  m_attachments = std::move(attachments);
+  for (const auto& a : m_attachments) {
+    specify_instance_attributes(a.vao, a.location, m_buffer, m_instance_size);
+  }
+
+  m_region = k_num_regions - 1;
+  ++m_reallocations;
+}
+
+void instance_buffer::wait_for_fence(size_t region) {
+  GLsync fence = m_fences[region];
+  if (fence == nullptr) {
+    return;
+  }
+
+  GLenum result = glClientWaitSync(fence, 0, 0);
+  while (result == GL_TIMEOUT_EXPIRED) {
+    result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, k_fence_timeout);
+  }
+
+  if (result == GL_WAIT_FAILED) {
+    std::cout << "Error: failed to wait for instance buffer fence.\n";
+  }
+
+  glDeleteSync(fence);
+  m_fences[region] = nullptr;
+}
+
+void instance_buffer::release() {
+  for (auto& fence : m_fences) {
+    if (fence != nullptr) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+
+  if (m_buffer != 0) {
+    if (m_data != nullptr) {
+      glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+      glUnmapBuffer(GL_ARRAY_BUFFER);
+      m_data = nullptr;
+    }
+    glDeleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+  }
+}
+
+}  // namespace graphics::utilities
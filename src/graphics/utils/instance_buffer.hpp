@@ -0,0 +1,117 @@
+#ifndef INSTANCE_BUFFER_HPP
+#define INSTANCE_BUFFER_HPP
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace graphics::utilities {
+
+/* Specifies instance attributes of vao reading from buffer, starting at
+ * location. Every instance is read as instance_size / 16 consecutive vec4
+ * attributes. */
+void specify_instance_attributes(GLuint vao,
+                                 GLuint location,
+                                 GLuint buffer,
+                                 size_t instance_size);
+
+/* Array buffer for per-instance data, split into k_num_regions regions that
+ * are written round-robin, one per frame. The buffer is mapped persistently
+ * and coherently when GL_ARB_buffer_storage is available, so the CPU writes
+ * straight into GPU-visible memory. Every region is guarded by a fence that
+ * is placed after the draw calls reading it, and the CPU only waits on that
+ * fence before overwriting the region three frames later.
+ *
+ * The regions grow geometrically when a frame needs more instances than they
+ * can hold, and the attributes of every attached vertex array are re-specified
+ * for the new buffer. */
+class instance_buffer {
+ public:
+  static constexpr size_t k_num_regions = 3;
+
+  instance_buffer(size_t capacity, size_t instance_size);
+
+  ~instance_buffer();
+
+  instance_buffer(const instance_buffer&) = delete;
+  instance_buffer& operator=(const instance_buffer&) = delete;
+
+  instance_buffer(instance_buffer&& other) noexcept;
+  instance_buffer& operator=(instance_buffer&& other) noexcept;
+
+  /* Specifies the instance attributes of vao, starting at location. Every
+   * instance is read as instance_size / 16 consecutive vec4 attributes. The
+   * vertex array is remembered and updated whenever the buffer grows. */
+  void attach(GLuint vao, GLuint location);
+
+  /* Stops updating vao when the buffer grows, so that it can read its
+   * instances from another buffer. */
+  void detach(GLuint vao);
+
+  /* Advances to the next region, growing the buffer if it holds fewer than
+   * count instances, waits until the GPU is done reading the region and
+   * returns a pointer to its first instance. Returns nullptr on failure. */
+  void* map_region(size_t count);
+
+  /* Makes the writes to the current region visible to the GPU. Must be called
+   * before the draw calls that read the region. */
+  void unmap_region();
+
+  /* Places a fence after the draw calls that read the current region. */
+  void fence_region();
+
+  /* Index of the current region's first instance, to be passed as the base
+   * instance of the draw call. */
+  GLuint base_instance() const { return m_region * m_capacity; }
+
+  GLuint buffer() const { return m_buffer; }
+
+  /* Number of instances that fit in one region. */
+  size_t capacity() const { return m_capacity; }
+
+  size_t instance_size() const { return m_instance_size; }
+
+  /* Number of times the buffer has been reallocated to grow. */
+  size_t reallocations() const { return m_reallocations; }
+
+  bool is_persistent() const { return m_persistent; }
+
+ private:
+  struct attachment {
+    GLuint vao;
+    GLuint location;
+  };
+
+  GLuint m_buffer = 0;
+
+  size_t m_capacity = 0;
+  size_t m_instance_size = 0;
+  size_t m_reallocations = 0;
+
+  std::vector<attachment> m_attachments;
+
+  // current region; starts at the last one so the first map selects region 0
+  size_t m_region = k_num_regions - 1;
+  std::array<GLsync, k_num_regions> m_fences{};
+
+  // persistently mapped base pointer, or the pointer of the current mapping
+  // when falling back to per-frame unsynchronized mapping
+  char* m_data = nullptr;
+  bool m_persistent = false;
+
+  size_t region_size() const { return m_capacity * m_instance_size; }
+
+  void allocate(size_t capacity);
+
+  void grow(size_t count);
+
+  void wait_for_fence(size_t region);
+
+  void release();
+};
+
+}  // namespace graphics::utilities
+
+#endif  // INSTANCE_BUFFER_HPP
@@ -0,0 +1,70 @@
+#ifndef INSTANCE_FORMAT_HPP
+#define INSTANCE_FORMAT_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace graphics::utilities {
+
+/* Layout of the per-instance data streamed to the vertex shader. Both carry
+ * an index into the material table of shader::material_table. */
+enum class instance_format {
+  // full model matrix, 64 bytes, attribute locations 3-6. The material index
+  // is stored in the matrix's bottom row, see set_instance_material
+  matrix,
+  // position, uniform scale, orientation and material index, 32 bytes,
+  // attribute locations 3-4
+  compact,
+};
+
+/* Instance transform and material decoded in the vertex shader. Only the
+ * vector part of the orientation is stored, its real part is restored as the
+ * non-negative root of the unit quaternion, which frees the last float for the
+ * material index. */
+struct compact_instance {
+  glm::vec3 position;
+  float scale;
+  glm::vec3 rotation;
+  // exact as a float up to 2^24
+  float material;
+};
+
+static_assert(sizeof(compact_instance) == 32, "compact_instance must be 32 bytes");
+
+/* Compact instance with the orientation flipped into the hemisphere of
+ * non-negative real parts, which is the same rotation. */
+inline compact_instance make_compact_instance(const glm::vec3& position,
+                                              float scale,
+                                              const glm::quat& orientation,
+                                              uint32_t material = 0) {
+  const float sign = orientation.w < 0.f ? -1.f : 1.f;
+  const glm::vec3 rotation(orientation.x, orientation.y, orientation.z);
+  return {position, scale, sign * rotation, static_cast<float>(material)};
+}
+
+/* Stores the material index in the bottom row of an affine model matrix,
+ * where the vertex shader reads it and restores the row to (0, 0, 0, 1). */
+inline void set_instance_material(glm::mat4& model, uint32_t material) {
+  model[0][3] = static_cast<float>(material);
+}
+
+/* World space position of an instance, e.g. to select its level of detail. */
+inline glm::vec3 instance_position(const compact_instance& instance) {
+  return instance.position;
+}
+
+inline glm::vec3 instance_position(const glm::mat4& model) {
+  return glm::vec3(model[3]);
+}
+
+constexpr size_t instance_size(instance_format format) {
+  return format == instance_format::compact ? sizeof(compact_instance)
+                                            : sizeof(glm::mat4);
+}
+
+}  // namespace graphics::utilities
+
+#endif  // INSTANCE_FORMAT_HPP
@@ -0,0 +1,64 @@
+#include "mesh_builder.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace graphics::utilities {
+
+static_assert(sizeof(vertex) == 9 * sizeof(float), "vertex must not be padded");
+
+GLuint mesh_builder::add_vertex(const vertex& v) {
+  const auto next_index = static_cast<GLuint>(m_mesh.vertices.size());
+  auto [it, inserted] = m_lookup.try_emplace(v, next_index);
+
+  if (inserted) {
+    m_mesh.vertices.push_back(v);
+  }
+  m_mesh.indices.push_back(it->second);
+
+  return it->second;
+}
+
+void mesh_builder::add_triangle(const vertex& a, const vertex& b, const vertex& c) {
+  add_vertex(a);
+  add_vertex(b);
+  add_vertex(c);
+}
+
+void mesh_builder::add_quad(const vertex& a,
+                            const vertex& b,
+                            const vertex& c,
+                            const vertex& d) {
+  add_triangle(a, b, c);
+  add_triangle(a, c, d);
+}
+
+indexed_mesh mesh_builder::build() {
+  m_lookup.clear();
+  return std::exchange(m_mesh, {});
+}
+
+size_t mesh_builder::vertex_hash::operator()(const vertex& v) const {
+  // FNV-1a over the vertex' bytes, consistent with vertex_equal
+  const auto* bytes = reinterpret_cast<const unsigned char*>(&v);
+
+  size_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < sizeof(vertex); ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+bool mesh_builder::vertex_equal::operator()(const vertex& a, const vertex& b) const {
+  return std::memcmp(&a, &b, sizeof(vertex)) == 0;
+}
+
+indexed_mesh make_indexed_mesh(const std::vector<vertex>& triangles) {
+  mesh_builder builder;
+  for (const auto& v : triangles) {
+    builder.add_vertex(v);
+  }
+  return builder.build();
+}
+
+}  // namespace graphics::utilities
@@ -0,0 +1,61 @@
+#ifndef MESH_BUILDER_HPP
+#define MESH_BUILDER_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+namespace graphics::utilities {
+
+struct vertex {
+  glm::vec4 position;
+  glm::vec3 normal;
+  glm::vec2 tex_coord;
+};
+
+/* Vertices and triangle list indices into them. */
+struct indexed_mesh {
+  std::vector<vertex> vertices;
+  std::vector<GLuint> indices;
+};
+
+/* Builds an indexed mesh from triangles, merging vertices whose position,
+ * normal and texture coordinates are bitwise equal. */
+class mesh_builder {
+ public:
+  /* Appends the index of v to the index list, adding v to the vertices if no
+   * equal vertex has been added before. Returns the index. */
+  GLuint add_vertex(const vertex& v);
+
+  void add_triangle(const vertex& a, const vertex& b, const vertex& c);
+
+  /* Adds the quad a-b-c-d, given in counter-clockwise order, as two
+   * triangles. */
+  void add_quad(const vertex& a, const vertex& b, const vertex& c, const vertex& d);
+
+  const indexed_mesh& mesh() const { return m_mesh; }
+
+  /* Moves the mesh out of the builder and resets it. */
+  indexed_mesh build();
+
+ private:
+  struct vertex_hash {
+    size_t operator()(const vertex& v) const;
+  };
+
+  struct vertex_equal {
+    bool operator()(const vertex& a, const vertex& b) const;
+  };
+
+  indexed_mesh m_mesh;
+  std::unordered_map<vertex, GLuint, vertex_hash, vertex_equal> m_lookup;
+};
+
+/* Deduplicates the vertices of a non-indexed triangle list. */
+indexed_mesh make_indexed_mesh(const std::vector<vertex>& triangles);
+
+}  // namespace graphics::utilities
+
+#endif  // MESH_BUILDER_HPP
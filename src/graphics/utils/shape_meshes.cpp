@@ -0,0 +1,181 @@
+#include "shape_meshes.hpp"
+
+#include <glm/ext.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+namespace graphics::utilities {
+
+/* Point of a lathe profile: distance from the axis, height, and the normal's
+ * radial and vertical components. v is the texture coordinate along the
+ * profile. */
+struct profile_point {
+  float radius;
+  float y;
+  glm::vec2 normal;
+  float v;
+};
+
+/* Revolves the profile, given from top to bottom, around the y axis and
+ * appends the surface to the mesh. Every profile point becomes a ring of
+ * slices + 1 vertices, the last one repeating the first with u = 1. Triangles
+ * collapsed at the axis are left out. */
+static void add_lathe(const std::vector<profile_point>& profile,
+                      int slices,
+                      indexed_mesh& mesh) {
+  const auto first = static_cast<GLuint>(mesh.vertices.size());
+  const GLuint ring_size = slices + 1;
+
+  for (const auto& p : profile) {
+    for (int j = 0; j <= slices; ++j) {
+      const float u = j / static_cast<float>(slices);
+      const float angle = 2.f * glm::pi<float>() * u;
+      const float s = std::sin(angle);
+      const float c = std::cos(angle);
+
+      const glm::vec3 normal(p.normal.x * s, p.normal.y, p.normal.x * c);
+      mesh.vertices.push_back(vertex{glm::vec4(p.radius * s, p.y, p.radius * c, 1.f),
+                                     glm::normalize(normal), glm::vec2(u, p.v)});
+    }
+  }
+
+  for (size_t i = 0; i + 1 < profile.size(); ++i) {
+    for (GLuint j = 0; j < static_cast<GLuint>(slices); ++j) {
+      const GLuint a = first + i * ring_size + j;
+      const GLuint b = a + ring_size;
+      const GLuint c = b + 1;
+      const GLuint d = a + 1;
+
+      // counter-clockwise seen from outside
+      if (profile[i].radius > 0.f) {
+        mesh.indices.insert(mesh.indices.end(), {a, b, d});
+      }
+      if (profile[i + 1].radius > 0.f) {
+        mesh.indices.insert(mesh.indices.end(), {d, b, c});
+      }
+    }
+  }
+}
+
+/* Profile points of a circular arc of the given radius around height y, from
+ * polar angle begin to end, measured from the +y axis. v runs from v_begin to
+ * v_end. */
+static void add_arc(float radius,
+                    float y,
+                    float begin,
+                    float end,
+                    int steps,
+                    float v_begin,
+                    float v_end,
+                    std::vector<profile_point>& profile) {
+  for (int i = 0; i <= steps; ++i) {
+    const float t = i / static_cast<float>(steps);
+    const float theta = begin + t * (end - begin);
+    const glm::vec2 normal(std::sin(theta), std::cos(theta));
+
+    // exactly on the axis at the poles
+    const bool pole = theta == 0.f || theta == glm::pi<float>();
+    const float v = v_begin + t * (v_end - v_begin);
+    profile.push_back({pole ? 0.f : radius * normal.x, y + radius * normal.y, normal, v});
+  }
+}
+
+indexed_mesh make_uv_sphere(float radius, int slices, int stacks) {
+  std::vector<profile_point> profile;
+  add_arc(radius, 0.f, 0.f, glm::pi<float>(), stacks, 0.f, 1.f, profile);
+
+  indexed_mesh mesh;
+  add_lathe(profile, slices, mesh);
+  return mesh;
+}
+
+indexed_mesh make_ico_sphere(float radius, int subdivisions) {
+  // corners of an icosahedron: cyclic permutations of (0, +-1, +-phi)
+  const float phi = (1.f + std::sqrt(5.f)) / 2.f;
+  std::vector<glm::vec3> points = {
+      {-1, phi, 0}, {1, phi, 0}, {-1, -phi, 0}, {1, -phi, 0},
+      {0, -1, phi}, {0, 1, phi}, {0, -1, -phi}, {0, 1, -phi},
+      {phi, 0, -1}, {phi, 0, 1}, {-phi, 0, -1}, {-phi, 0, 1}};
+  for (auto& p : points) {
+    p = glm::normalize(p);
+  }
+
+  std::vector<GLuint> triangles = {
+      0, 11, 5,  0, 5,  1,  0,  1,  7,  0,  7, 10, 0, 10, 11, 1, 5, 9, 5, 11,
+      4, 11, 10, 2, 10, 7,  6,  7,  1,  8,  3, 9,  4, 3,  4,  2, 3, 2, 6, 3,
+      6, 8,  3,  8, 9,  4,  9,  5,  2,  4,  11, 6, 2, 10, 8,  6, 7, 9, 8, 1};
+
+  for (int level = 0; level < subdivisions; ++level) {
+    // every edge is split once, whichever of its triangles comes first
+    std::map<std::pair<GLuint, GLuint>, GLuint> midpoints;
+    auto midpoint = [&points, &midpoints](GLuint a, GLuint b) {
+      auto [it, inserted] =
+          midpoints.try_emplace(std::minmax(a, b), static_cast<GLuint>(points.size()));
+      if (inserted) {
+        points.push_back(glm::normalize(points[a] + points[b]));
+      }
+      return it->second;
+    };
+
+    std::vector<GLuint> split;
+    split.reserve(4 * triangles.size());
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+      const GLuint a = triangles[i];
+      const GLuint b = triangles[i + 1];
+      const GLuint c = triangles[i + 2];
+      const GLuint ab = midpoint(a, b);
+      const GLuint bc = midpoint(b, c);
+      const GLuint ca = midpoint(c, a);
+
+      split.insert(split.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+    }
+    triangles = std::move(split);
+  }
+
+  indexed_mesh mesh;
+  mesh.vertices.reserve(points.size());
+  for (const auto& p : points) {
+    // spherical mapping; the seam is not split, as no texture is applied yet
+    const glm::vec2 tex_coord(0.5f + std::atan2(p.x, p.z) / (2.f * glm::pi<float>()),
+                              std::acos(std::clamp(p.y, -1.f, 1.f)) / glm::pi<float>());
+    mesh.vertices.push_back(vertex{glm::vec4(radius * p, 1.f), p, tex_coord});
+  }
+  mesh.indices = std::move(triangles);
+
+  return mesh;
+}
+
+indexed_mesh make_cylinder(float radius, float height, int slices) {
+  const float h = height / 2.f;
+  const glm::vec2 up(0.f, 1.f);
+  const glm::vec2 out(1.f, 0.f);
+
+  indexed_mesh mesh;
+  add_lathe({{0.f, h, up, 0.f}, {radius, h, up, 1.f}}, slices, mesh);
+  add_lathe({{radius, h, out, 0.f}, {radius, -h, out, 1.f}}, slices, mesh);
+  add_lathe({{radius, -h, -up, 0.f}, {0.f, -h, -up, 1.f}}, slices, mesh);
+  return mesh;
+}
+
+indexed_mesh make_capsule(float radius, float height, int slices, int stacks) {
+  const float h = height / 2.f;
+  const int cap_stacks = std::max(stacks / 2, 1);
+  const float half_pi = glm::pi<float>() / 2.f;
+
+  // v runs over the whole length, split in proportion
+  const float length = height + 2.f * radius;
+  const float v_cap = radius / length;
+
+  std::vector<profile_point> profile;
+  add_arc(radius, h, 0.f, half_pi, cap_stacks, 0.f, v_cap, profile);
+  add_arc(radius, -h, half_pi, glm::pi<float>(), cap_stacks, 1.f - v_cap, 1.f, profile);
+
+  indexed_mesh mesh;
+  add_lathe(profile, slices, mesh);
+  return mesh;
+}
+
+}  // namespace graphics::utilities
@@ -0,0 +1,29 @@
+#ifndef SHAPE_MESHES_HPP
+#define SHAPE_MESHES_HPP
+
+#include <utils/mesh_builder.hpp>
+
+namespace graphics::utilities {
+
+/* Procedural meshes centered at the origin with the y axis as their axis of
+ * symmetry. All have smooth normals and texture coordinates, and their
+ * tessellation parameters set the level of detail. */
+
+/* Sphere of slices meridians and stacks parallels, 2 * slices * (stacks - 1)
+ * triangles. slices >= 3, stacks >= 2. */
+indexed_mesh make_uv_sphere(float radius, int slices, int stacks);
+
+/* Icosahedron whose triangles are split into four subdivisions times, with the
+ * new vertices pushed onto the sphere, 20 * 4^subdivisions triangles. */
+indexed_mesh make_ico_sphere(float radius, int subdivisions);
+
+/* Closed cylinder of the given height, 4 * slices triangles. */
+indexed_mesh make_cylinder(float radius, float height, int slices);
+
+/* Cylinder of the given height capped by hemispheres of stacks / 2 parallels
+ * each, so its total height is height + 2 * radius. stacks >= 2. */
+indexed_mesh make_capsule(float radius, float height, int slices, int stacks);
+
+}  // namespace graphics::utilities
+
+#endif  // SHAPE_MESHES_HPP
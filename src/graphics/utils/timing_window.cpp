@@ -0,0 +1,60 @@
+#include "timing_window.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace graphics::utilities {
+
+timing_window::timing_window(size_t size) : m_capacity(std::max<size_t>(size, 1)) {
+  m_samples.reserve(m_capacity);
+}
+
+void timing_window::add(double ms) {
+  if (m_samples.size() < m_capacity) {
+    m_samples.push_back(ms);
+  } else {
+    m_samples[m_next] = ms;
+  }
+
+  m_next = (m_next + 1) % m_capacity;
+}
+
+double timing_window::last() const {
+  if (m_samples.empty()) {
+    return 0.0;
+  }
+
+  return m_samples[(m_next + m_capacity - 1) % m_capacity];
+}
+
+timing_stats timing_window::stats() const {
+  timing_stats result;
+  result.samples = m_samples.size();
+  if (m_samples.empty()) {
+    return result;
+  }
+
+  auto sorted = m_samples;
+  std::sort(sorted.begin(), sorted.end());
+
+  // nearest-rank percentile
+  auto percentile = [&sorted](double p) {
+    const size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+  };
+
+  double sum = 0.0;
+  for (double ms : sorted) {
+    sum += ms;
+  }
+
+  result.mean = sum / sorted.size();
+  result.p50 = percentile(0.50);
+  result.p95 = percentile(0.95);
+  result.p99 = percentile(0.99);
+  result.max = sorted.back();
+
+  return result;
+}
+
+}  // namespace graphics::utilities
@@ -0,0 +1,45 @@
+#ifndef TIMING_WINDOW_HPP
+#define TIMING_WINDOW_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace graphics::utilities {
+
+/* Summary of the samples in a timing_window, in milliseconds. */
+struct timing_stats {
+  size_t samples = 0;
+  double mean = 0.0;
+  double p50 = 0.0;
+  double p95 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+};
+
+/* Sliding window over the most recent timing samples. Adding a sample never
+ * allocates once the window is full. */
+class timing_window {
+ public:
+  explicit timing_window(size_t size);
+
+  /* Adds a sample, replacing the oldest one when the window is full. */
+  void add(double ms);
+
+  /* Sorts a copy of the samples, so this is meant for reporting rather than
+   * for every frame. */
+  timing_stats stats() const;
+
+  /* The most recent sample, or 0 if there is none. */
+  double last() const;
+
+  size_t size() const { return m_samples.size(); }
+
+ private:
+  std::vector<double> m_samples;
+  size_t m_capacity;
+  size_t m_next = 0;
+};
+
+}  // namespace graphics::utilities
+
+#endif  // TIMING_WINDOW_HPP
@@ -0,0 +1,29 @@
+#ifndef VERTEX_FORMAT_HPP
+#define VERTEX_FORMAT_HPP
+
+#include <glad/glad.h>
+
+namespace graphics::utilities {
+
+/* Layout of the per-vertex data in the vertex buffer. Both layouts feed the
+ * same shader inputs at attribute locations 0-2. */
+enum class vertex_format {
+  // separate float arrays of vec4 positions, vec3 normals and vec2 texture
+  // coordinates, 36 bytes per vertex
+  separate,
+  // interleaved vec3 position, normal packed as GL_INT_2_10_10_10_REV and
+  // half-float texture coordinates, 20 bytes per vertex
+  packed,
+};
+
+struct packed_vertex {
+  GLfloat position[3];
+  GLuint normal;
+  GLhalf tex_coord[2];
+};
+
+static_assert(sizeof(packed_vertex) == 20, "packed_vertex must be 20 bytes");
+
+}  // namespace graphics::utilities
+
+#endif  // VERTEX_FORMAT_HPP
@@ -6,18 +6,240 @@
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
 
+#include <dynamics/fixed_timestep.hpp>
+#include <dynamics/particle_arrays.hpp>
+#include <dynamics/physics_thread.hpp>
 #include <particle.hpp>
+#include <renderer/culling.hpp>
+#include <renderer/deferred_renderer.hpp>
+#include <renderer/depth_prepass.hpp>
+#include <renderer/gpu_culling.hpp>
+#include <renderer/gpu_profiler.hpp>
+#include <renderer/lod.hpp>
+#include <renderer/offscreen_target.hpp>
+#include <renderer/renderer.hpp>
+#include <shader/frame_uniforms.hpp>
+#include <shader/light_clusters.hpp>
+#include <shader/material_table.hpp>
 #include <shader/phong_shader.hpp>
+#include <shader/program_cache.hpp>
+#include <utils/cpu_profiler.hpp>
 #include <utils/cube_mesh.hpp>
+#include <utils/frame_arena.hpp>
+#include <utils/shape_meshes.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+namespace dynamics = physics::dynamics;
+namespace renderer = graphics::renderer;
+namespace shader = graphics::shader;
+namespace utilities = graphics::utilities;
+
+// per-instance data layout; compact halves the upload size of matrices
+constexpr auto k_instance_format = utilities::instance_format::compact;
+
+// per-vertex data layout; packed is interleaved and 20 bytes per vertex
+constexpr auto k_vertex_format = utilities::vertex_format::packed;
+
+// depth range of the projection
+constexpr float k_near = 0.1f;
+constexpr float k_far = 100.f;
+
+// frames over which the scope statistics of windowed runs are kept
+constexpr size_t k_profile_frames = 120;
+
+// the simulation runs at 120 Hz whatever the display's rate, and catches up
+// at most 8 steps per frame
+constexpr double k_physics_step = 1.0 / 120.0;
+constexpr int k_max_substeps = 8;
+
+// simulated duration of a headless frame, so that their output is reproducible
+constexpr double k_headless_frame_time = 1.0 / 60.0;
+
+/* Command line options. */
+struct options {
+  // frames to render offscreen without a window, or 0 to open a window
+  int headless_frames = 0;
+
+  int width = 640;
+  int height = 480;
+
+  // headless frames to write to frame_<n>.ppm
+  std::vector<int> dump_frames;
+
+  // file for the CPU scope times of every frame, if not empty
+  std::string csv_path;
+
+  // start with deferred instead of forward shading
+  bool deferred = false;
+
+  // lay down depth before shading
+  bool depth_prepass = false;
+
+  // simulate on a thread of its own, in real time even when headless
+  bool physics_thread = false;
+};
+
+static void print_usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [--headless <frames>] [--size <width>x<height>] "
+          "[--dump <frame>]... [--csv <path>] [--deferred] [--depth-prepass] "
+          "[--physics-thread]\n",
+          program);
+}
+
+static std::optional<options> parse_options(int argc, char** argv) {
+  options opts;
+
+  for (int i = 1; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+
+    if (strcmp(argv[i], "--deferred") == 0) {
+      opts.deferred = true;
+    } else if (strcmp(argv[i], "--depth-prepass") == 0) {
+      opts.depth_prepass = true;
+    } else if (strcmp(argv[i], "--physics-thread") == 0) {
+      opts.physics_thread = true;
+    } else if (strcmp(argv[i], "--headless") == 0 && has_value) {
+      opts.headless_frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--size") == 0 && has_value) {
+      if (sscanf(argv[++i], "%dx%d", &opts.width, &opts.height) != 2) {
+        return std::nullopt;
+      }
+    } else if (strcmp(argv[i], "--dump") == 0 && has_value) {
+      opts.dump_frames.push_back(atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--csv") == 0 && has_value) {
+      opts.csv_path = argv[++i];
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  if (opts.headless_frames < 0 || opts.width <= 0 || opts.height <= 0) {
+    return std::nullopt;
+  }
+
+  return opts;
+}
+
+/* Creates a window with an OpenGL 4.3 context, or 4.2 if that fails. Headless
+ * windows are hidden and their context is created with EGL, falling back to
+ * OSMesa, which both work without a display, e.g. on Mesa's llvmpipe. */
+static GLFWwindow* create_window(const options& opts) {
+  auto context_apis = std::vector<int>{GLFW_NATIVE_CONTEXT_API};
+  if (opts.headless_frames > 0) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    context_apis = {GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API};
+  }
+
+  // OpenGL 4.3 enables GPU culling, 4.2 is enough for everything else
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  for (int context_api : context_apis) {
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, context_api);
+
+    for (int minor : {3, 2}) {
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+
+      if (auto window = glfwCreateWindow(opts.width, opts.height, "OpenGL Triangle",
+                                         NULL, NULL)) {
+        return window;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+/* Unrotated instance in k_instance_format. */
+static auto make_instance(const glm::vec3& position, float scale, uint32_t material) {
+  if constexpr (k_instance_format == utilities::instance_format::compact) {
+    return utilities::make_compact_instance(position, scale,
+                                            glm::quat{1.f, 0.f, 0.f, 0.f}, material);
+  } else {
+    glm::mat4 model(1.f);
+    model[0][0] = model[1][1] = model[2][2] = scale;
+    model[3] = glm::vec4(position, 1.f);
+    utilities::set_instance_material(model, material);
+    return model;
+  }
+}
+
+using instance = decltype(make_instance(glm::vec3{}, 0.f, 0));
+using instance_list = utilities::frame_vector<instance>;
+
+/* The scene's cubes, allocated from the frame's arena. */
+static instance_list make_cubes(utilities::frame_arena& arena) {
+  auto cubes = instance_list{utilities::arena_allocator<instance>{arena}};
+  cubes.reserve(1);
+  cubes.push_back(make_instance(glm::vec3{0.f, 0.f, -3.f}, 1.f, 0));
+  return cubes;
+}
+
+constexpr int k_num_spheres = 32;
+
+// spring constant and damping of the springs holding the spheres in place
+constexpr float k_sphere_stiffness = 20.f;
+constexpr float k_sphere_damping = 0.2f;
+
+/* Rest position of sphere i, in a row receding from the camera to show the
+ * spheres' levels of detail. */
+static glm::vec3 sphere_anchor(int i) {
+  return glm::vec3(-1.5f, -1.f, -2.f + 1.5f * i);
+}
+
+/* Unit mass spheres at their anchors, bobbing at different phases. */
+static dynamics::particle_arrays make_sphere_bodies() {
+  auto bodies = dynamics::particle_arrays{k_num_spheres};
+  for (int i = 0; i < k_num_spheres; ++i) {
+    bodies.add(sphere_anchor(i), glm::vec3(0.f, 1.5f * glm::sin(0.7f * i), 0.f), 1.f);
+  }
+  return bodies;
+}
+
+/* Advances the spheres on damped springs towards their anchors by dt. */
+static void step_spheres(dynamics::particle_arrays& bodies, float dt) {
+  for (int i = 0; i < k_num_spheres; ++i) {
+    bodies.add_force(i, k_sphere_stiffness * (sphere_anchor(i) - bodies.position(i)) -
+                            k_sphere_damping * bodies.velocity(i));
+  }
+  bodies.integrate(dt, glm::vec3(0.f));
+}
+
+/* n spheres at position_of(i), allocated from the frame's arena. */
+template <class PositionFn>
+static instance_list make_spheres(utilities::frame_arena& arena,
+                                  uint32_t material,
+                                  size_t n,
+                                  PositionFn position_of) {
+  auto spheres = instance_list{utilities::arena_allocator<instance>{arena}};
+  spheres.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    spheres.push_back(make_instance(position_of(i), 0.4f, material));
+  }
+  return spheres;
+}
+
 static void error_callback(int error, const char* description) {
   fprintf(stderr, "Error: %s\n", description);
 }
 
+// toggled with the D key
+static bool s_deferred_shading = false;
+
+// toggled with the P key
+static bool s_depth_prepass = false;
+
 static void key_callback(GLFWwindow* window,
                          int key,
                          int scancode,
@@ -25,19 +247,39 @@ static void key_callback(GLFWwindow* window,
                          int mods) {
   if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     glfwSetWindowShouldClose(window, GLFW_TRUE);
+
+  if (key == GLFW_KEY_D && action == GLFW_PRESS) {
+    s_deferred_shading = !s_deferred_shading;
+    printf("%s shading\n", s_deferred_shading ? "Deferred" : "Forward");
+  }
+
+  if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+    s_depth_prepass = !s_depth_prepass;
+    printf("Depth pre-pass %s\n", s_depth_prepass ? "on" : "off");
+  }
 }
 
-int main(void) {
+int main(int argc, char** argv) {
+  const auto opts = parse_options(argc, argv);
+  if (!opts) {
+    print_usage(argv[0]);
+    exit(EXIT_FAILURE);
+  }
+  const bool headless = opts->headless_frames > 0;
+
   glfwSetErrorCallback(error_callback);
 
+#ifdef GLFW_PLATFORM_NULL
+  // since GLFW 3.4, headless runs need no display server at all
+  if (headless) {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  }
+#endif
+
   if (!glfwInit())
     exit(EXIT_FAILURE);
 
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-  GLFWwindow* window = glfwCreateWindow(640, 480, "OpenGL Triangle", NULL, NULL);
+  GLFWwindow* window = create_window(*opts);
   if (!window) {
     glfwTerminate();
     exit(EXIT_FAILURE);
@@ -47,11 +289,85 @@ int main(void) {
 
   glfwMakeContextCurrent(window);
   gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
-  glfwSwapInterval(1);
 
-  auto phong_shader = graphics::shader::phong_shader{};
-  auto [phong_vao, matrix_buffer_object] =
-      graphics::utilities::make_cube_mesh_arrays(1.f, 1.f, 1.f);
+  // headless frames are rendered as fast as possible into a framebuffer object
+  glfwSwapInterval(headless ? 0 : 1);
+  auto offscreen = std::optional<renderer::offscreen_target>{};
+  if (headless) {
+    offscreen.emplace(opts->width, opts->height);
+    if (!offscreen->is_complete()) {
+      glfwTerminate();
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // reuse the programs linked by previous runs on the same driver
+  shader::enable_program_cache("shader_cache");
+
+  // compile on the driver's threads, so programs are submitted up front and
+  // the first frames do not wait for them
+  shader::enable_parallel_compile();
+
+  // shade only the lights of each fragment's cluster when storage buffers are
+  // available, otherwise all lights of the per-frame uniform block
+  const bool clustered_lighting = shader::light_clusters::is_supported();
+  auto light_clusters = std::optional<shader::light_clusters>{};
+  if (clustered_lighting) {
+    light_clusters.emplace();
+  }
+
+  const auto lights = std::vector<shader::point_light>{
+      {glm::vec3(-2.5f, 2.5f, 1.f), 20.f, glm::vec3(1.f), 0.f},
+      {glm::vec3(2.5f, 2.5f, 1.f), 20.f, glm::vec3(1.f), 0.f},
+  };
+
+  auto frame_uniforms = shader::frame_uniforms{};
+
+  // colors of the instances, selected per instance by index
+  auto materials = shader::material_table{};
+  const uint32_t sphere_material = materials.add({glm::vec3(0.2f, 0.4f, 0.9f), 50.f});
+  auto phong_shader = shader::phong_shader{k_instance_format, clustered_lighting};
+
+  // both paths are compiled up front, so switching between them is instant
+  auto deferred_renderer =
+      renderer::deferred_renderer{k_instance_format, clustered_lighting};
+  s_deferred_shading = opts->deferred;
+
+  // depth-only program for either path
+  auto depth_prepass = renderer::depth_prepass{k_instance_format};
+  s_depth_prepass = opts->depth_prepass;
+  auto cube = utilities::make_cube_mesh_elements(1.f, 1.f, 1.f, k_instance_format,
+                                                 k_vertex_format);
+
+  // radius of the unit cube's bounding sphere
+  const float cube_radius = glm::sqrt(3.f) / 2.f;
+  auto culler = renderer::frustum_culler{};
+
+  // unit spheres from 1280 down to 20 triangles in one set of buffers, the
+  // finest up to 6 units from the camera
+  auto sphere_levels = std::vector<utilities::submesh>{};
+  auto sphere = utilities::make_shared_mesh_elements(
+      {utilities::make_ico_sphere(1.f, 3), utilities::make_ico_sphere(1.f, 2),
+       utilities::make_ico_sphere(1.f, 1), utilities::make_ico_sphere(1.f, 0)},
+      sphere_levels, k_instance_format, k_vertex_format);
+  auto sphere_lods = renderer::lod_selector{{6.f, 12.f, 24.f}};
+
+  // cull on the GPU and draw indirectly when compute shaders are available
+  auto gpu_culler = std::optional<renderer::gpu_culler>{};
+  if (renderer::gpu_culler::is_supported()) {
+    gpu_culler.emplace(cube, k_instance_format);
+  }
+  printf("Culling on the %s\n", gpu_culler ? "GPU" : "CPU");
+
+  // scratch data of a frame: instances and sort keys
+  auto frame_arena = utilities::frame_arena{};
+
+  auto draw_queue = renderer::draw_queue{};
+  draw_queue.set_frame_arena(&frame_arena);
+
+  const glm::vec3 camera_position(1.f, 0.f, -5.f);
+  const glm::mat4 view_matrix =
+      glm::lookAt(camera_position, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
 
   glEnable(GL_CULL_FACE);
   glCullFace(GL_BACK);
@@ -62,33 +378,239 @@ int main(void) {
   glDepthFunc(GL_LEQUAL);
   glDepthRange(0.0f, 1.0f);
 
-  while (!glfwWindowShouldClose(window)) {
+  // headless runs are reproducible, their first frame already shows the cubes
+  if (headless && !phong_shader.wait()) {
+    fprintf(stderr, "Error: failed to link the phong program\n");
+    glfwTerminate();
+    exit(EXIT_FAILURE);
+  }
+  if (headless && opts->deferred && !deferred_renderer.wait()) {
+    fprintf(stderr, "Error: failed to link the deferred shading programs\n");
+    glfwTerminate();
+    exit(EXIT_FAILURE);
+  }
+  if (headless && opts->depth_prepass && !depth_prepass.wait()) {
+    fprintf(stderr, "Error: failed to link the depth pre-pass program\n");
+    glfwTerminate();
+    exit(EXIT_FAILURE);
+  }
+
+  // headless runs report the times of all their frames
+  const size_t profile_frames =
+      headless ? size_t(opts->headless_frames) : k_profile_frames;
+  auto gpu_profiler = renderer::gpu_profiler{profile_frames};
+  auto cpu_profiler = utilities::cpu_profiler{profile_frames};
+  if (!opts->csv_path.empty()) {
+    cpu_profiler.open_csv(opts->csv_path);
+  }
+
+  // simulated independently of the frame rate, between frames or
+  // concurrently with them
+  auto sphere_bodies = make_sphere_bodies();
+  auto stepper = dynamics::fixed_timestep{k_physics_step, k_max_substeps};
+  auto sphere_physics = std::optional<dynamics::physics_thread>{};
+  if (opts->physics_thread) {
+    sphere_physics.emplace(std::move(sphere_bodies), k_physics_step, k_max_substeps,
+                           step_spheres);
+  }
+
+  const auto run_start = std::chrono::steady_clock::now();
+  auto last_frame = run_start;
+
+  for (int frame = 0;
+       headless ? frame < opts->headless_frames : !glfwWindowShouldClose(window);
+       ++frame) {
+    cpu_profiler.begin_frame();
+    gpu_profiler.begin_frame();
+
     int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
+    if (headless) {
+      width = offscreen->width();
+      height = offscreen->height();
+    } else {
+      glfwGetFramebufferSize(window, &width, &height);
+    }
     const float ratio = width / (float)height;
 
-    glViewport(0, 0, width, height);
-    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-    glClearDepth(1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // the deferred path draws into its G-buffer first, and shades forward
+    // until its programs have linked
+    const GLuint target = headless ? offscreen->framebuffer() : 0;
+    const bool deferred = s_deferred_shading && deferred_renderer.ready();
 
-    auto matrix_buffer = std::vector<glm::mat4>{glm::mat4(1.f)};
-    matrix_buffer[0][3] = glm::vec4{0.f, 0.f, -3.f, 1.f};
-    graphics::utilities::update_matrix_buffer(matrix_buffer_object, matrix_buffer);
+    gpu_profiler.begin("clear");
+    if (deferred) {
+      deferred_renderer.begin_geometry(width, height);
+    } else {
+      glBindFramebuffer(GL_FRAMEBUFFER, target);
+      glViewport(0, 0, width, height);
+      glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+      glClearDepth(1.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    gpu_profiler.end();
 
     glm::mat4 proj_matrix =
-        glm::perspective(glm::pi<float>() * 60.f / 180.f, ratio, 0.1f, 100.f);
+        glm::perspective(glm::pi<float>() * 60.f / 180.f, ratio, k_near, k_far);
+
+    // only the instances inside the view frustum are uploaded and drawn
+    const auto view_frustum = renderer::make_frustum(proj_matrix * view_matrix);
+    culler.reset_counters();
+
+    const auto now = std::chrono::steady_clock::now();
+    const double frame_time =
+        headless ? k_headless_frame_time
+                 : std::chrono::duration<double>(now - last_frame).count();
+    last_frame = now;
+
+    cpu_profiler.begin("physics");
+    if (!sphere_physics) {
+      for (int steps = stepper.advance(frame_time); steps > 0; --steps) {
+        step_spheres(sphere_bodies, float(stepper.step()));
+      }
+    }
+    cpu_profiler.end();
+
+    // the spheres are blended between their last two states
+    cpu_profiler.begin("instances");
+    const auto cubes = make_cubes(frame_arena);
+    const auto spheres = [&] {
+      if (sphere_physics) {
+        const auto& transforms = sphere_physics->latest();
+        const float alpha = transforms.alpha(now);
+        return make_spheres(frame_arena, sphere_material, transforms.current.size(),
+                            [&](size_t i) { return transforms.position(i, alpha); });
+      }
+      const float alpha = stepper.alpha();
+      return make_spheres(
+          frame_arena, sphere_material, sphere_bodies.size(),
+          [&](size_t i) { return sphere_bodies.interpolated_position(i, alpha); });
+    }();
+    cpu_profiler.end();
 
-    phong_shader.bind();
-    phong_shader.set_projection_matrix(proj_matrix);
+    // culling writes the instance buffer
+    cpu_profiler.begin("upload");
+    gpu_profiler.begin("cull");
+    size_t n_instances = 0;
+    if (gpu_culler) {
+      gpu_culler->cull(view_frustum, cubes, cube_radius);
+    } else {
+      n_instances = culler.cull(view_frustum, cubes, cube_radius, cube.matrix_buffer);
+    }
 
-    glBindVertexArray(phong_vao);
-    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, matrix_buffer.size());
+    // levels of detail are selected on the CPU
+    sphere_lods.cull(culler, view_frustum, spheres, 1.f, camera_position,
+                     sphere.matrix_buffer, frame_arena);
+    gpu_profiler.end();
+    cpu_profiler.end();
 
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+    frame_uniforms.set_view_matrix(view_matrix);
+    frame_uniforms.set_camera_pos(camera_position);
+    frame_uniforms.set_projection_matrix(proj_matrix);
+    frame_uniforms.upload();
+    materials.upload();
+
+    if (light_clusters) {
+      light_clusters->update(lights, view_matrix, proj_matrix, k_near, k_far, width,
+                             height);
+    }
+
+    // one batch for all cubes, so its depth does not matter, and one per
+    // level of the spheres. Nothing is drawn until the program has linked
+    cpu_profiler.begin("submit");
+    const auto submit_scene = [&](GLuint program) {
+      if (gpu_culler) {
+        draw_queue.submit(gpu_culler->make_draw_item(program, 0, 0.f));
+      } else {
+        draw_queue.submit(renderer::make_draw_item(cube, program, 0, 0.f, n_instances));
+      }
+      sphere_lods.submit(draw_queue, sphere, sphere_levels, program, 0);
+    };
+
+    const bool lit = deferred || phong_shader.ready();
+    const bool prepass = lit && s_depth_prepass && depth_prepass.ready();
+    if (prepass) {
+      gpu_profiler.begin("prepass");
+      depth_prepass.begin();
+      submit_scene(depth_prepass.program());
+      draw_queue.flush();
+      depth_prepass.begin_lit_pass();
+      gpu_profiler.end();
+    }
+
+    gpu_profiler.begin("draw");
+    if (lit) {
+      submit_scene(deferred ? deferred_renderer.geometry_program()
+                            : phong_shader.program());
+    }
+    draw_queue.flush();
+    if (prepass) {
+      depth_prepass.end();
+    }
+    gpu_profiler.end();
+
+    if (deferred) {
+      gpu_profiler.begin("lighting");
+      deferred_renderer.shade(target, view_matrix, proj_matrix);
+      gpu_profiler.end();
+    }
+    cpu_profiler.end();
+
+    if (gpu_culler) {
+      gpu_culler->fence();
+    } else {
+      cube.matrix_buffer.fence_region();
+    }
+    sphere.matrix_buffer.fence_region();
+
+    if (!headless) {
+      cpu_profiler.begin("swap");
+      gpu_profiler.begin("swap");
+      glfwSwapBuffers(window);
+      gpu_profiler.end();
+      cpu_profiler.end();
+    }
+
+    gpu_profiler.end_frame();
+    cpu_profiler.end_frame();
+    frame_arena.reset();
+
+    // frames are read back outside the measured scopes
+    const auto& dumps = opts->dump_frames;
+    if (!headless) {
+      glfwPollEvents();
+    } else if (std::find(dumps.begin(), dumps.end(), frame) != dumps.end()) {
+      offscreen->write_ppm("frame_" + std::to_string(frame) + ".ppm");
+    }
   }
 
+  glFinish();
+  gpu_profiler.flush();
+
+  if (headless) {
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start)
+            .count();
+
+    const int n_frames = opts->headless_frames;
+    printf("Rendered %d frames of %dx%d in %.3f s, %.1f fps\n", n_frames,
+           opts->width, opts->height, seconds, n_frames / seconds);
+  }
+  cpu_profiler.close_csv();
+  cpu_profiler.print();
+  printf("Frame arena: high-water mark %zu of %zu bytes, %zu overflows\n",
+         frame_arena.high_water(), frame_arena.capacity(), frame_arena.overflows());
+  gpu_profiler.print();
+  if (sphere_physics) {
+    sphere_physics->stop();
+    printf("Physics thread: %zu steps, %zu dropped\n", sphere_physics->steps(),
+           sphere_physics->dropped_steps());
+  } else {
+    printf("Physics: %zu steps, %zu dropped\n", stepper.steps(),
+           stepper.dropped_steps());
+  }
+
+  offscreen.reset();
+
   glfwDestroyWindow(window);
 
   glfwTerminate();
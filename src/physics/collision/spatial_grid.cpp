@@ -0,0 +1,199 @@
+#include "spatial_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace physics::collision {
+
+// ranges smaller than this are not worth starting a thread for
+constexpr size_t k_min_range = 4096;
+
+// largest float below 2^31, small enough for the neighbor cells to fit in
+// int32_t too
+constexpr float k_max_cell = 2147483520.f;
+
+static int32_t cell_coord(float p, float inv_cell_size) {
+  // converting coordinates past the range of int32_t is undefined, so far
+  // away and NaN positions share the cells at its ends
+  const float c = std::floor(p * inv_cell_size);
+  if (!(c < k_max_cell)) {
+    return int32_t(k_max_cell);
+  }
+  return int32_t(std::max(c, -k_max_cell));
+}
+
+spatial_grid::spatial_grid(float cell_size, unsigned num_threads)
+    : m_inv_cell_size(1.f / cell_size), m_workers(num_threads) {
+  m_thread_pairs.resize(m_workers.size());
+}
+
+spatial_grid::~spatial_grid() = default;
+
+template <class Fn>
+void spatial_grid::parallel_for(size_t n, Fn fn) {
+  const size_t n_ranges = std::clamp<size_t>(n / k_min_range, 1, m_workers.size());
+  const size_t range = (n + n_ranges - 1) / n_ranges;
+
+  m_workers.run(n_ranges, [&](size_t r) {
+    const size_t begin = std::min(r * range, n);
+    fn(r, begin, std::min(begin + range, n));
+  });
+}
+
+uint32_t spatial_grid::slot(int32_t cx, int32_t cy, int32_t cz) const {
+  const uint32_t h = uint32_t(cx) * 73856093u ^ uint32_t(cy) * 19349663u ^
+                     uint32_t(cz) * 83492791u;
+  return h & uint32_t(m_table_size - 1);
+}
+
+void spatial_grid::build(const float* x, const float* y, const float* z, size_t n) {
+  // about two slots per particle keep the cells of different slots apart
+  size_t table_size = 1024;
+  while (table_size < 2 * n) {
+    table_size *= 2;
+  }
+  if (table_size != m_table_size) {
+    m_counts = std::make_unique<std::atomic<uint32_t>[]>(table_size);
+    m_table_size = table_size;
+  }
+  for (size_t s = 0; s < m_table_size; ++s) {
+    m_counts[s].store(0, std::memory_order_relaxed);
+  }
+
+  m_particle_slot.resize(n);
+  m_order.resize(n);
+  m_sorted_x.resize(n);
+  m_sorted_y.resize(n);
+  m_sorted_z.resize(n);
+  m_slot_start.resize(m_table_size + 1);
+
+  // count the particles of every slot
+  parallel_for(n, [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const uint32_t s = slot(cell_coord(x[i], m_inv_cell_size),
+                              cell_coord(y[i], m_inv_cell_size),
+                              cell_coord(z[i], m_inv_cell_size));
+      m_particle_slot[i] = s;
+      m_counts[s].fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+
+  // the counts become the first index of every slot, and the cursors of the
+  // scatter
+  uint32_t offset = 0;
+  for (size_t s = 0; s < m_table_size; ++s) {
+    m_slot_start[s] = offset;
+    offset += m_counts[s].exchange(offset, std::memory_order_relaxed);
+  }
+  m_slot_start[m_table_size] = offset;
+
+  // scatter the particles to their slots' ranges
+  parallel_for(n, [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const uint32_t s = m_particle_slot[i];
+      m_order[m_counts[s].fetch_add(1, std::memory_order_relaxed)] = uint32_t(i);
+    }
+  });
+
+  // the threads fill a slot in the order they get to it, so its particles are
+  // sorted by index to make the order the same in every run. Slots hold about
+  // one particle, so this costs about as much as the scan
+  parallel_for(m_table_size, [&](size_t, size_t begin, size_t end) {
+    for (size_t s = begin; s < end; ++s) {
+      uint32_t* first = m_order.data() + m_slot_start[s];
+      uint32_t* last = m_order.data() + m_slot_start[s + 1];
+      for (uint32_t* i = first + 1; i < last; ++i) {
+        const uint32_t particle = *i;
+        uint32_t* j = i;
+        for (; j > first && *(j - 1) > particle; --j) {
+          *j = *(j - 1);
+        }
+        *j = particle;
+      }
+    }
+  });
+
+  // copy the positions in that order
+
+  parallel_for(n, [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const uint32_t p = m_order[i];
+      m_sorted_x[i] = x[p];
+      m_sorted_y[i] = y[p];
+      m_sorted_z[i] = z[p];
+    }
+  });
+}
+
+void spatial_grid::find_pairs(float distance, std::vector<particle_pair>& pairs) {
+  const size_t n = m_order.size();
+  const float distance_squared = distance * distance;
+
+  std::vector<size_t> thread_tests(m_workers.size(), 0);
+  for (auto& found : m_thread_pairs) {
+    found.clear();
+  }
+
+  parallel_for(n, [&](size_t thread, size_t begin, size_t end) {
+    auto& found = m_thread_pairs[thread];
+    size_t tests = 0;
+
+    // consecutive particles mostly share a cell and its neighbor slots
+    uint32_t neighbors[27];
+    size_t n_neighbors = 0;
+    int32_t last_cell[3] = {0, 0, 0};
+
+    for (size_t i = begin; i < end; ++i) {
+      const float px = m_sorted_x[i];
+      const float py = m_sorted_y[i];
+      const float pz = m_sorted_z[i];
+
+      const int32_t cell[3] = {cell_coord(px, m_inv_cell_size),
+                               cell_coord(py, m_inv_cell_size),
+                               cell_coord(pz, m_inv_cell_size)};
+      if (i == begin || !std::equal(cell, cell + 3, last_cell)) {
+        n_neighbors = 0;
+        for (int32_t dz = -1; dz <= 1; ++dz) {
+          for (int32_t dy = -1; dy <= 1; ++dy) {
+            for (int32_t dx = -1; dx <= 1; ++dx) {
+              neighbors[n_neighbors++] =
+                  slot(cell[0] + dx, cell[1] + dy, cell[2] + dz);
+            }
+          }
+        }
+
+        // cells sharing a slot would otherwise be scanned twice
+        std::sort(neighbors, neighbors + n_neighbors);
+        n_neighbors = std::unique(neighbors, neighbors + n_neighbors) - neighbors;
+        std::copy(cell, cell + 3, last_cell);
+      }
+
+      // every pair is found from its lower index
+      for (size_t k = 0; k < n_neighbors; ++k) {
+        const uint32_t s = neighbors[k];
+        const uint32_t first = std::max(m_slot_start[s], uint32_t(i + 1));
+        const uint32_t last = m_slot_start[s + 1];
+
+        for (uint32_t j = first; j < last; ++j) {
+          const float dx = m_sorted_x[j] - px;
+          const float dy = m_sorted_y[j] - py;
+          const float dz = m_sorted_z[j] - pz;
+          if (dx * dx + dy * dy + dz * dz <= distance_squared) {
+            found.push_back({uint32_t(i), j});
+          }
+        }
+        tests += last > first ? last - first : 0;
+      }
+    }
+    thread_tests[thread] = tests;
+  });
+
+  pairs.clear();
+  m_tests = 0;
+  for (unsigned t = 0; t < m_workers.size(); ++t) {
+    pairs.insert(pairs.end(), m_thread_pairs[t].begin(), m_thread_pairs[t].end());
+    m_tests += thread_tests[t];
+  }
+}
+
+}  // namespace physics::collision
@@ -0,0 +1,113 @@
+#ifndef SPATIAL_GRID_HPP
+#define SPATIAL_GRID_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <utils/worker_pool.hpp>
+
+namespace physics::collision {
+
+/* Two particles closer than the contact distance, by their index in the
+ * grid's cell order, with first < second. */
+struct particle_pair {
+  uint32_t first;
+  uint32_t second;
+};
+
+/* Broadphase for many particles of similar size. The particles are binned
+ * into cubic cells of equal size, which are hashed into a table, so the grid
+ * is unbounded and its memory depends only on the number of particles.
+ * Particles more than 2^31 cells from the origin share the outermost cells.
+ *
+ * Every step rebuilds the grid with a counting sort on a pool of threads:
+ * the particles are counted per cell, the counts are turned into offsets, and
+ * the particles are scattered to their cell's range, where they are ordered by
+ * index. The order is the same in every run. The positions are copied in
+ * that order, so the particles of a cell, and the candidates tested against a
+ * particle, are contiguous in memory. Other per-particle data can be
+ * reordered the same way with gather.
+ *
+ *   grid.build(x, y, z, n);
+ *   grid.find_pairs(2.f * radius, pairs);
+ *   for (auto pair : pairs) {
+ *     // grid.order()[pair.first] is the particle's index in x, y and z
+ *   } */
+class spatial_grid {
+ public:
+  /* cell_size must be at least the largest contact distance passed to
+   * find_pairs. Runs on num_threads threads, or one per core if 0. */
+  explicit spatial_grid(float cell_size, unsigned num_threads = 0);
+
+  ~spatial_grid();
+
+  spatial_grid(const spatial_grid&) = delete;
+  spatial_grid& operator=(const spatial_grid&) = delete;
+
+  /* Sorts n particles at the given positions into their cells. */
+  void build(const float* x, const float* y, const float* z, size_t n);
+
+  /* Replaces pairs with all pairs of particles at most distance apart, found
+   * by testing every particle against those of its own and the 26 neighboring
+   * cells. */
+  void find_pairs(float distance, std::vector<particle_pair>& pairs);
+
+  /* Copies per-particle data into cell order, out[i] = in[order()[i]]. */
+  template <class T>
+  void gather(const T* in, T* out) const {
+    for (size_t i = 0; i < m_order.size(); ++i) {
+      out[i] = in[m_order[i]];
+    }
+  }
+
+  /* Original index of each particle, in cell order. */
+  const std::vector<uint32_t>& order() const { return m_order; }
+
+  /* Positions in cell order. */
+  const float* sorted_x() const { return m_sorted_x.data(); }
+  const float* sorted_y() const { return m_sorted_y.data(); }
+  const float* sorted_z() const { return m_sorted_z.data(); }
+
+  size_t size() const { return m_order.size(); }
+
+  /* Distance tests made by the last find_pairs. */
+  size_t tests() const { return m_tests; }
+
+ private:
+  /* Calls fn(range, begin, end) on the workers for consecutive ranges of
+   * [0, n), numbered from 0 to at most the number of workers. */
+  template <class Fn>
+  void parallel_for(size_t n, Fn fn);
+
+  /* Table slot of the cell with the given integer coordinates. */
+  uint32_t slot(int32_t cx, int32_t cy, int32_t cz) const;
+
+  float m_inv_cell_size;
+  utilities::worker_pool m_workers;
+
+  // particles per slot while building, then the cursors of the scatter
+  std::unique_ptr<std::atomic<uint32_t>[]> m_counts;
+  size_t m_table_size = 0;
+
+  // first particle of every slot in cell order, and one past the last
+  std::vector<uint32_t> m_slot_start;
+
+  std::vector<uint32_t> m_particle_slot;
+  std::vector<uint32_t> m_order;
+
+  std::vector<float> m_sorted_x;
+  std::vector<float> m_sorted_y;
+  std::vector<float> m_sorted_z;
+
+  // pairs found by each thread
+  std::vector<std::vector<particle_pair>> m_thread_pairs;
+
+  size_t m_tests = 0;
+};
+
+}  // namespace physics::collision
+
+#endif  // SPATIAL_GRID_HPP
@@ -0,0 +1,230 @@
+#include "sweep_and_prune.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace physics::collision {
+
+static uint64_t pair_key(uint32_t a, uint32_t b) {
+  return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+/* Order of the endpoints along an axis. Mins go before maxes of the same
+ * value, so that touching boxes overlap. */
+static bool endpoint_less(float a, uint32_t a_box_max, float b, uint32_t b_box_max) {
+  return a < b || (a == b && !(a_box_max & 1u) && (b_box_max & 1u));
+}
+
+static bool intersect(const aabb& a, const aabb& b) {
+  return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y &&
+         b.min.y <= a.max.y && a.min.z <= b.max.z && b.min.z <= a.max.z;
+}
+
+uint32_t sweep_and_prune::add(const aabb& bounds) {
+  uint32_t box;
+  if (!m_free.empty()) {
+    box = m_free.back();
+    m_free.pop_back();
+    m_boxes[box] = bounds;
+    m_alive[box] = true;
+  } else {
+    box = uint32_t(m_boxes.size());
+    m_boxes.push_back(bounds);
+    m_alive.push_back(true);
+  }
+
+  // appended after all others, the next sweep moves the endpoints into place
+  // and finds the box's pairs on the way
+  for (int axis = 0; axis < 3; ++axis) {
+    m_axes[axis].push_back({bounds.min[axis], box << 1});
+    m_axes[axis].push_back({bounds.max[axis], box << 1 | 1u});
+  }
+  ++m_num_added;
+  return box;
+}
+
+void sweep_and_prune::remove(uint32_t box) {
+  if (!m_alive[box]) {
+    return;
+  }
+
+  // the next sweep moves the endpoints past all others, which ends the box's
+  // overlaps, and then drops them
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  m_boxes[box] = {glm::vec3(inf), glm::vec3(inf)};
+  m_alive[box] = false;
+  m_dead.push_back(box);
+}
+
+void sweep_and_prune::update(uint32_t box, const aabb& bounds) {
+  if (m_alive[box]) {
+    m_boxes[box] = bounds;
+  }
+}
+
+bool sweep_and_prune::overlapping(uint32_t a, uint32_t b) const {
+  return m_pairs.count(pair_key(a, b)) != 0;
+}
+
+void sweep_and_prune::refresh_axis(int axis) {
+  for (auto& e : m_axes[axis]) {
+    const aabb& bounds = m_boxes[e.box_max >> 1];
+    e.value = (e.box_max & 1u) ? bounds.max[axis] : bounds.min[axis];
+  }
+}
+
+void sweep_and_prune::sort_axis(int axis) {
+  auto& endpoints = m_axes[axis];
+
+  for (size_t i = 1; i < endpoints.size(); ++i) {
+    const endpoint e = endpoints[i];
+
+    size_t j = i;
+    for (; j > 0 && endpoint_less(e.value, e.box_max, endpoints[j - 1].value,
+                                  endpoints[j - 1].box_max);
+         --j) {
+      const endpoint& passed = endpoints[j - 1];
+
+      // a min passing a max starts an overlap, a max passing a min ends one
+      if ((e.box_max ^ passed.box_max) & 1u) {
+        const uint32_t a = e.box_max >> 1;
+        const uint32_t b = passed.box_max >> 1;
+        if (a != b) {
+          m_candidates.push_back(pair_key(a, b));
+        }
+      }
+      endpoints[j] = passed;
+    }
+    endpoints[j] = e;
+    m_swaps += i - j;
+  }
+}
+
+void sweep_and_prune::rebuild() {
+  for (auto& endpoints : m_axes) {
+    std::sort(endpoints.begin(), endpoints.end(),
+              [](const endpoint& a, const endpoint& b) {
+                return endpoint_less(a.value, a.box_max, b.value, b.box_max);
+              });
+  }
+
+  // sweep along the axis where the box centers spread the most, so that
+  // stacks and rows, which share an interval along the other axes, keep few
+  // boxes active at a time
+  glm::vec3 sum(0.f);
+  glm::vec3 sum_squared(0.f);
+  size_t n_alive = 0;
+  for (uint32_t box = 0; box < m_boxes.size(); ++box) {
+    if (m_alive[box]) {
+      const glm::vec3 center = 0.5f * (m_boxes[box].min + m_boxes[box].max);
+      sum += center;
+      sum_squared += center * center;
+      ++n_alive;
+    }
+  }
+
+  int sweep_axis = 0;
+  if (n_alive > 0) {
+    const glm::vec3 mean = sum / float(n_alive);
+    const glm::vec3 variance = sum_squared / float(n_alive) - mean * mean;
+    for (int axis = 1; axis < 3; ++axis) {
+      if (variance[axis] > variance[sweep_axis]) {
+        sweep_axis = axis;
+      }
+    }
+  }
+
+  // every pair overlapping along the axis is tested when the later min is
+  // reached, and the pairs that are no longer found stop overlapping
+  m_candidates.clear();
+  m_active.clear();
+  m_active_index.resize(m_boxes.size());
+  for (const auto& e : m_axes[sweep_axis]) {
+    const uint32_t box = e.box_max >> 1;
+    if (e.box_max & 1u) {
+      // swap the last active box into the place of this one
+      const uint32_t index = m_active_index[box];
+      m_active[index] = m_active.back();
+      m_active_index[m_active[index]] = index;
+      m_active.pop_back();
+      continue;
+    }
+
+    for (const uint32_t other : m_active) {
+      if (intersect(m_boxes[box], m_boxes[other])) {
+        m_candidates.push_back(pair_key(box, other));
+      }
+    }
+    m_active_index[box] = uint32_t(m_active.size());
+    m_active.push_back(box);
+  }
+
+  for (const uint64_t key : m_pairs) {
+    m_candidates.push_back(key);
+  }
+}
+
+void sweep_and_prune::sweep() {
+  m_added.clear();
+  m_removed.clear();
+  m_candidates.clear();
+  m_swaps = 0;
+
+  for (int axis = 0; axis < 3; ++axis) {
+    refresh_axis(axis);
+  }
+
+  // every added box can take a swap per endpoint, which costs more than
+  // sorting from scratch when it is more than about log n boxes
+  if (m_num_added > 16) {
+    rebuild();
+  } else {
+    for (int axis = 0; axis < 3; ++axis) {
+      sort_axis(axis);
+    }
+  }
+  m_num_added = 0;
+
+  // removed boxes are at infinity, after all others
+  for (auto& endpoints : m_axes) {
+    endpoints.resize(endpoints.size() - 2 * m_dead.size());
+  }
+
+  // two removed boxes keep their order at infinity, so their endpoints never
+  // swap, and their pairs are ended here instead
+  if (!m_dead.empty()) {
+    for (const uint64_t key : m_pairs) {
+      if (!m_alive[uint32_t(key >> 32)] || !m_alive[uint32_t(key)]) {
+        m_candidates.push_back(key);
+      }
+    }
+  }
+
+  // a pair can have swapped on several axes, or both started and stopped
+  // overlapping, so only its final state counts
+  std::sort(m_candidates.begin(), m_candidates.end());
+  m_candidates.erase(std::unique(m_candidates.begin(), m_candidates.end()),
+                     m_candidates.end());
+
+  for (const uint64_t key : m_candidates) {
+    const auto a = uint32_t(key >> 32);
+    const auto b = uint32_t(key);
+
+    const bool overlap =
+        m_alive[a] && m_alive[b] && intersect(m_boxes[a], m_boxes[b]);
+    const bool known = m_pairs.count(key) != 0;
+
+    if (overlap && !known) {
+      m_pairs.insert(key);
+      m_added.push_back({a, b});
+    } else if (!overlap && known) {
+      m_pairs.erase(key);
+      m_removed.push_back({a, b});
+    }
+  }
+
+  m_free.insert(m_free.end(), m_dead.begin(), m_dead.end());
+  m_dead.clear();
+}
+
+}  // namespace physics::collision
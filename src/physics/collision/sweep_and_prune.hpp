@@ -0,0 +1,127 @@
+#ifndef SWEEP_AND_PRUNE_HPP
+#define SWEEP_AND_PRUNE_HPP
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace physics::collision {
+
+/* Axis-aligned bounding box. Boxes that only touch overlap. */
+struct aabb {
+  glm::vec3 min;
+  glm::vec3 max;
+};
+
+/* Two boxes whose bounds overlap, with first < second. */
+struct box_pair {
+  uint32_t first;
+  uint32_t second;
+};
+
+/* Broadphase that finds the pairs of overlapping boxes by keeping the boxes'
+ * min and max endpoints sorted along each axis. The endpoint arrays stay
+ * sorted between steps and are repaired with insertion sort, which costs one
+ * swap per endpoint that passed another since the last step, so a step with
+ * little motion is close to linear in the number of boxes.
+ *
+ * Only pairs whose endpoints swapped can start or stop overlapping, so only
+ * those are tested, and the changes are reported as added and removed pairs.
+ * When many boxes were added since the last sweep, which insertion sort would
+ * handle in quadratic time, the endpoints are sorted from scratch and all
+ * pairs are found with a single sweep instead, along the axis where the box
+ * centers spread the most.
+ *
+ *   for (auto& body : bodies) {
+ *     broadphase.update(body.box, body.bounds());
+ *   }
+ *   broadphase.sweep();
+ *   for (auto pair : broadphase.added()) { ... }
+ *   for (auto pair : broadphase.removed()) { ... } */
+class sweep_and_prune {
+ public:
+  /* Adds a box and returns its handle. Its pairs are reported by the next
+   * sweep. */
+  uint32_t add(const aabb& bounds);
+
+  /* Removes a box. Its pairs are reported as removed by the next sweep, which
+   * also frees its handle. */
+  void remove(uint32_t box);
+
+  /* Moves a box. Its endpoints are sorted again by the next sweep. */
+  void update(uint32_t box, const aabb& bounds);
+
+  /* Sorts the endpoints and finds the pairs that started or stopped
+   * overlapping since the last sweep. */
+  void sweep();
+
+  /* Pairs that started overlapping in the last sweep. */
+  const std::vector<box_pair>& added() const { return m_added; }
+
+  /* Pairs that stopped overlapping in the last sweep, including those of
+   * removed boxes. */
+  const std::vector<box_pair>& removed() const { return m_removed; }
+
+  /* Number of overlapping pairs. */
+  size_t num_pairs() const { return m_pairs.size(); }
+
+  /* Number of boxes. */
+  size_t size() const { return m_boxes.size() - m_free.size() - m_dead.size(); }
+
+  /* Endpoint swaps made by the last sweep, a measure of its cost. */
+  size_t swaps() const { return m_swaps; }
+
+  /* Whether boxes a and b overlapped in the last sweep. */
+  bool overlapping(uint32_t a, uint32_t b) const;
+
+ private:
+  /* Bound of a box along one axis. The box and whether it is the max bound
+   * are packed into one word, as box << 1 | is_max. */
+  struct endpoint {
+    float value;
+    uint32_t box_max;
+  };
+
+  /* Updates the endpoint values along an axis from the boxes. */
+  void refresh_axis(int axis);
+
+  /* Insertion sorts the endpoints along an axis, collecting the pairs whose
+   * overlap along it changed. */
+  void sort_axis(int axis);
+
+  /* Sorts all endpoints from scratch and replaces the candidates with all
+   * overlapping pairs. */
+  void rebuild();
+
+  std::vector<aabb> m_boxes;
+  std::vector<bool> m_alive;
+
+  // handles that can be reused, and those of boxes whose endpoints are still
+  // to be dropped by the next sweep
+  std::vector<uint32_t> m_free;
+  std::vector<uint32_t> m_dead;
+
+  std::array<std::vector<endpoint>, 3> m_axes;
+
+  // boxes added since the last sweep
+  size_t m_num_added = 0;
+
+  // overlapping pairs, as first << 32 | second
+  std::unordered_set<uint64_t> m_pairs;
+
+  std::vector<uint64_t> m_candidates;
+  std::vector<uint32_t> m_active;
+  std::vector<uint32_t> m_active_index;
+  std::vector<box_pair> m_added;
+  std::vector<box_pair> m_removed;
+
+  size_t m_swaps = 0;
+};
+
+}  // namespace physics::collision
+
+#endif  // SWEEP_AND_PRUNE_HPP
@@ -0,0 +1,43 @@
+#include "fixed_timestep.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace physics::dynamics {
+
+fixed_timestep::fixed_timestep(double step, int max_substeps)
+    : m_step(step), m_max_substeps(std::max(max_substeps, 1)) {}
+
+int fixed_timestep::advance(double frame_time) {
+  // a NaN or infinite duration would stay in the accumulator for good
+  if (std::isfinite(frame_time)) {
+    m_accumulator += std::max(frame_time, 0.0);
+  }
+
+  // the quotient can round to the next or previous integer, which the
+  // remainder tells apart
+  double due = std::floor(m_accumulator / m_step);
+  if (m_accumulator - due * m_step >= m_step) {
+    due += 1.0;
+  } else if (m_accumulator - due * m_step < 0.0) {
+    due -= 1.0;
+  }
+
+  const int n_steps = int(std::min(due, double(m_max_substeps)));
+  m_accumulator -= n_steps * m_step;
+
+  // keep the fraction of a step, the rest is lost to the cap
+  if (due > n_steps) {
+    m_dropped_steps += size_t(due) - n_steps;
+    m_accumulator = std::fmod(m_accumulator, m_step);
+  }
+
+  // subtracting whole steps rounds too, and a remainder outside [0, step)
+  // would put alpha outside [0, 1]
+  m_accumulator = std::clamp(m_accumulator, 0.0, std::nextafter(m_step, 0.0));
+
+  m_steps += n_steps;
+  return n_steps;
+}
+
+}  // namespace physics::dynamics
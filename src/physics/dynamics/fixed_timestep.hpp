@@ -0,0 +1,55 @@
+#ifndef FIXED_TIMESTEP_HPP
+#define FIXED_TIMESTEP_HPP
+
+#include <cstddef>
+
+namespace physics::dynamics {
+
+/* Advances a simulation in steps of constant length, independent of the frame
+ * rate. Every frame adds its real duration to an accumulator, and as many
+ * whole steps are taken as fit into it. The remainder is carried over to the
+ * next frame and exposed as alpha, the fraction of a step that rendering
+ * should blend from the previous to the current state.
+ *
+ *   for (int i = stepper.advance(frame_time); i > 0; --i) {
+ *     simulate(stepper.step());
+ *   }
+ *   render(interpolate(previous, current, stepper.alpha()));
+ *
+ * Frames that would need more than max_substeps steps, e.g. after a stall,
+ * take max_substeps and drop the rest, so the simulation slows down instead of
+ * falling further behind every frame. */
+class fixed_timestep {
+ public:
+  explicit fixed_timestep(double step, int max_substeps = 5);
+
+  /* Adds the duration of a frame, in seconds, and returns the number of steps
+   * to take. Negative durations add nothing, and NaN or infinite ones are
+   * ignored. */
+  int advance(double frame_time);
+
+  /* Length of a step, in seconds. */
+  double step() const { return m_step; }
+
+  /* Fraction of a step accumulated but not yet simulated, in [0, 1]. */
+  float alpha() const { return float(m_accumulator / m_step); }
+
+  /* Steps taken since construction. */
+  size_t steps() const { return m_steps; }
+
+  /* Steps dropped since construction because of the substep cap. */
+  size_t dropped_steps() const { return m_dropped_steps; }
+
+ private:
+  double m_step;
+  int m_max_substeps;
+
+  double m_accumulator = 0.0;
+
+  size_t m_steps = 0;
+  size_t m_dropped_steps = 0;
+};
+
+}  // namespace physics::dynamics
+
+#endif  // FIXED_TIMESTEP_HPP
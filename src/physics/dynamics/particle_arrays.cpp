@@ -0,0 +1,164 @@
+#include "particle_arrays.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+namespace physics::dynamics {
+
+static size_t round_up(size_t n, size_t multiple) {
+  return (n + multiple - 1) / multiple * multiple;
+}
+
+/* Copies the first n values of from to a new array of the given size, whose
+ * remaining values are zero. */
+static aligned_array<float> resized(const aligned_array<float>& from,
+                                    size_t n,
+                                    size_t size) {
+  aligned_array<float> to(size);
+  if (n > 0) {
+    std::memcpy(to.data(), from.data(), n * sizeof(float));
+  }
+  std::fill(to.data() + n, to.data() + size, 0.f);
+  return to;
+}
+
+particle_arrays::particle_arrays(size_t capacity) {
+  reserve(capacity);
+}
+
+size_t particle_arrays::padded_size() const {
+  return round_up(m_size, k_batch_size);
+}
+
+void particle_arrays::reserve(size_t n) {
+  const size_t capacity = round_up(n, k_batch_size);
+  if (capacity <= m_capacity) {
+    return;
+  }
+
+  for (auto* array : {&m_px, &m_py, &m_pz, &m_prev_px, &m_prev_py, &m_prev_pz,
+                      &m_vx, &m_vy, &m_vz, &m_fx, &m_fy, &m_fz, &m_inv_mass}) {
+    *array = resized(*array, m_size, capacity);
+  }
+  m_capacity = capacity;
+}
+
+size_t particle_arrays::add(const glm::vec3& position,
+                            const glm::vec3& velocity,
+                            float inv_mass) {
+  if (m_size == m_capacity) {
+    reserve(std::max(2 * m_capacity, size_t{64}));
+  }
+
+  const size_t i = m_size++;
+  m_inv_mass[i] = inv_mass;
+  set_position(i, position);
+  set_velocity(i, velocity);
+  m_fx[i] = m_fy[i] = m_fz[i] = 0.f;
+  return i;
+}
+
+void particle_arrays::clear() {
+  // the padding has to stay zero
+  const size_t n = padded_size();
+  for (auto* array : {&m_px, &m_py, &m_pz, &m_prev_px, &m_prev_py, &m_prev_pz,
+                      &m_vx, &m_vy, &m_vz, &m_fx, &m_fy, &m_fz, &m_inv_mass}) {
+    std::fill(array->data(), array->data() + n, 0.f);
+  }
+  m_size = 0;
+}
+
+void particle_arrays::add_force(size_t i, const glm::vec3& f) {
+  m_fx[i] += f.x;
+  m_fy[i] += f.y;
+  m_fz[i] += f.z;
+}
+
+void particle_arrays::set_position(size_t i, const glm::vec3& p) {
+  // placed, not moved, so there is nothing to interpolate from
+  m_px[i] = m_prev_px[i] = p.x;
+  m_py[i] = m_prev_py[i] = p.y;
+  m_pz[i] = m_prev_pz[i] = p.z;
+}
+
+void particle_arrays::set_velocity(size_t i, const glm::vec3& v) {
+  // static particles would otherwise drift, since positions are advanced by
+  // the velocity of every particle
+  const glm::vec3 velocity = m_inv_mass[i] > 0.f ? v : glm::vec3(0.f);
+  m_vx[i] = velocity.x;
+  m_vy[i] = velocity.y;
+  m_vz[i] = velocity.z;
+}
+
+#if defined(__AVX2__)
+/* v += dt * (f * w + g), x += dt * v and f = 0 for one component of 8
+ * particles, where g is zero for static particles. The old x is kept in
+ * prev. Products and sums are not fused, so they round like the scalar
+ * kernel. */
+static inline void integrate_batch(float* x,
+                                   float* prev,
+                                   float* v,
+                                   float* f,
+                                   __m256 w,
+                                   __m256 g,
+                                   __m256 dt) {
+  const __m256 a = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(f), w), g);
+
+  const __m256 pos = _mm256_load_ps(x);
+  const __m256 vel = _mm256_add_ps(_mm256_mul_ps(a, dt), _mm256_load_ps(v));
+  _mm256_store_ps(prev, pos);
+  _mm256_store_ps(v, vel);
+  _mm256_store_ps(x, _mm256_add_ps(_mm256_mul_ps(vel, dt), pos));
+  _mm256_store_ps(f, _mm256_setzero_ps());
+}
+#endif
+
+void particle_arrays::integrate(float dt, const glm::vec3& gravity) {
+  const size_t n = padded_size();
+
+#if defined(__AVX2__)
+  const __m256 dt8 = _mm256_set1_ps(dt);
+  const __m256 gx = _mm256_set1_ps(gravity.x);
+  const __m256 gy = _mm256_set1_ps(gravity.y);
+  const __m256 gz = _mm256_set1_ps(gravity.z);
+
+  for (size_t i = 0; i < n; i += k_batch_size) {
+    const __m256 w = _mm256_load_ps(&m_inv_mass[i]);
+    const __m256 dynamic = _mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_GT_OQ);
+
+    integrate_batch(&m_px[i], &m_prev_px[i], &m_vx[i], &m_fx[i], w,
+                    _mm256_and_ps(dynamic, gx), dt8);
+    integrate_batch(&m_py[i], &m_prev_py[i], &m_vy[i], &m_fy[i], w,
+                    _mm256_and_ps(dynamic, gy), dt8);
+    integrate_batch(&m_pz[i], &m_prev_pz[i], &m_vz[i], &m_fz[i], w,
+                    _mm256_and_ps(dynamic, gz), dt8);
+  }
+#else
+  // the same operations in the same order as the AVX2 kernel
+  for (size_t i = 0; i < n; ++i) {
+    const float w = m_inv_mass[i];
+    const glm::vec3 g = w > 0.f ? gravity : glm::vec3(0.f);
+
+    m_vx[i] += (m_fx[i] * w + g.x) * dt;
+    m_vy[i] += (m_fy[i] * w + g.y) * dt;
+    m_vz[i] += (m_fz[i] * w + g.z) * dt;
+
+    m_prev_px[i] = m_px[i];
+    m_prev_py[i] = m_py[i];
+    m_prev_pz[i] = m_pz[i];
+
+    m_px[i] += m_vx[i] * dt;
+    m_py[i] += m_vy[i] * dt;
+    m_pz[i] += m_vz[i] * dt;
+
+    m_fx[i] = m_fy[i] = m_fz[i] = 0.f;
+  }
+#endif
+}
+
+}  // namespace physics::dynamics
@@ -0,0 +1,126 @@
+#ifndef PARTICLE_ARRAYS_HPP
+#define PARTICLE_ARRAYS_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace physics::dynamics {
+
+/* Array of trivial values whose first element is aligned to k_alignment
+ * bytes, so that SIMD kernels can use aligned loads and a cache line never
+ * holds the end of one array and the start of another. */
+template <class T>
+class aligned_array {
+ public:
+  static constexpr size_t k_alignment = 64;
+
+  aligned_array() = default;
+
+  explicit aligned_array(size_t size)
+      : m_data(static_cast<T*>(::operator new(size * sizeof(T),
+                                              std::align_val_t{k_alignment}))),
+        m_size(size) {}
+
+  T* data() { return m_data.get(); }
+  const T* data() const { return m_data.get(); }
+
+  T& operator[](size_t i) { return m_data.get()[i]; }
+  const T& operator[](size_t i) const { return m_data.get()[i]; }
+
+  size_t size() const { return m_size; }
+
+ private:
+  struct deleter {
+    void operator()(T* p) const {
+      ::operator delete(p, std::align_val_t{k_alignment});
+    }
+  };
+
+  std::unique_ptr<T, deleter> m_data;
+  size_t m_size = 0;
+};
+
+/* Point masses stored as structure of arrays: one aligned array per
+ * component of the positions, previous positions, velocities and forces, and
+ * one of inverse masses. Integration streams through the arrays, 8 particles
+ * at a time with AVX2, so its speed is set by memory bandwidth.
+ *
+ * The arrays are padded to a multiple of k_batch_size with particles of
+ * inverse mass 0 and zero velocity, which the kernels process along with the
+ * others and never move. Particles with inverse mass 0 are static, and their
+ * velocity is always zero. */
+class particle_arrays {
+ public:
+  // the same in every build, so that code built with and without AVX2 agrees
+  // on the layout
+  static constexpr size_t k_batch_size = 8;
+
+  explicit particle_arrays(size_t capacity = 0);
+
+  /* Adds a particle and returns its index. The velocity of a static particle
+   * is ignored. */
+  size_t add(const glm::vec3& position, const glm::vec3& velocity, float inv_mass);
+
+  /* Makes room for n particles without reallocating. */
+  void reserve(size_t n);
+
+  void clear();
+
+  size_t size() const { return m_size; }
+
+  /* Number of particles the kernels process, the size rounded up to a whole
+   * batch. */
+  size_t padded_size() const;
+
+  /* Accumulates a force on particle i until the next integration. */
+  void add_force(size_t i, const glm::vec3& f);
+
+  /* Advances all particles by dt with semi-implicit Euler: velocities by the
+   * accumulated forces and gravity, then positions by the new velocities.
+   * Static particles are not affected by gravity. Clears the forces and keeps
+   * the positions before the step. Every product and sum is rounded on its
+   * own, so builds with and without AVX2 give the same results. */
+  void integrate(float dt, const glm::vec3& gravity);
+
+  glm::vec3 position(size_t i) const { return {m_px[i], m_py[i], m_pz[i]}; }
+
+  /* Position of particle i before the last integration. */
+  glm::vec3 previous_position(size_t i) const {
+    return {m_prev_px[i], m_prev_py[i], m_prev_pz[i]};
+  }
+
+  /* Position of particle i blended from the one before the last integration
+   * (alpha 0) to the current one (alpha 1). */
+  glm::vec3 interpolated_position(size_t i, float alpha) const {
+    return glm::mix(previous_position(i), position(i), alpha);
+  }
+
+  glm::vec3 velocity(size_t i) const { return {m_vx[i], m_vy[i], m_vz[i]}; }
+  float inv_mass(size_t i) const { return m_inv_mass[i]; }
+
+  void set_position(size_t i, const glm::vec3& p);
+
+  /* Sets the velocity of particle i, or zero if it is static. */
+  void set_velocity(size_t i, const glm::vec3& v);
+
+  const float* positions_x() const { return m_px.data(); }
+  const float* positions_y() const { return m_py.data(); }
+  const float* positions_z() const { return m_pz.data(); }
+
+ private:
+  size_t m_size = 0;
+  size_t m_capacity = 0;
+
+  aligned_array<float> m_px, m_py, m_pz;
+  aligned_array<float> m_prev_px, m_prev_py, m_prev_pz;
+  aligned_array<float> m_vx, m_vy, m_vz;
+  aligned_array<float> m_fx, m_fy, m_fz;
+  aligned_array<float> m_inv_mass;
+};
+
+}  // namespace physics::dynamics
+
+#endif  // PARTICLE_ARRAYS_HPP
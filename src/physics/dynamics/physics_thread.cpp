@@ -0,0 +1,79 @@
+#include "physics_thread.hpp"
+
+#include <algorithm>
+
+namespace physics::dynamics {
+
+using clock = std::chrono::steady_clock;
+
+float body_transforms::alpha(clock::time_point now) const {
+  if (step <= 0.0) {
+    return 1.f;
+  }
+
+  const double behind = std::chrono::duration<double>(now - time).count();
+  return float(std::clamp(behind / step, 0.0, 1.0));
+}
+
+physics_thread::physics_thread(particle_arrays bodies,
+                               double step,
+                               int max_substeps,
+                               step_function step_fn)
+    : m_bodies(std::move(bodies)),
+      m_stepper(step, max_substeps),
+      m_step_fn(std::move(step_fn)) {
+  publish(clock::now());
+  m_thread = std::thread(&physics_thread::run, this);
+}
+
+physics_thread::~physics_thread() {
+  stop();
+}
+
+void physics_thread::stop() {
+  m_running = false;
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void physics_thread::run() {
+  auto last = clock::now();
+
+  while (m_running) {
+    const auto now = clock::now();
+    const double elapsed = std::chrono::duration<double>(now - last).count();
+    last = now;
+
+    const int n_steps = m_stepper.advance(elapsed);
+    for (int i = 0; i < n_steps; ++i) {
+      m_step_fn(m_bodies, float(m_stepper.step()));
+    }
+    if (n_steps > 0) {
+      publish(clock::now());
+    }
+
+    // sleep until the next step is due
+    const double until_next = (1.0 - m_stepper.alpha()) * m_stepper.step();
+    std::this_thread::sleep_until(now + std::chrono::duration<double>(until_next));
+  }
+}
+
+void physics_thread::publish(clock::time_point time) {
+  // the slot's vectors keep their storage, so only the first publishes
+  // allocate
+  body_transforms& transforms = m_transforms.back();
+  transforms.previous.resize(m_bodies.size());
+  transforms.current.resize(m_bodies.size());
+
+  for (size_t i = 0; i < m_bodies.size(); ++i) {
+    transforms.previous[i] = m_bodies.previous_position(i);
+    transforms.current[i] = m_bodies.position(i);
+  }
+  transforms.time = time;
+  transforms.step = m_stepper.step();
+
+  m_transforms.publish();
+}
+
+}  // namespace physics::dynamics
@@ -0,0 +1,92 @@
+#ifndef PHYSICS_THREAD_HPP
+#define PHYSICS_THREAD_HPP
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <dynamics/fixed_timestep.hpp>
+#include <dynamics/particle_arrays.hpp>
+#include <dynamics/triple_buffer.hpp>
+
+namespace physics::dynamics {
+
+/* Positions of all bodies after one step and before it, as published by a
+ * physics_thread. */
+struct body_transforms {
+  std::vector<glm::vec3> previous;
+  std::vector<glm::vec3> current;
+
+  // when the current positions were reached, and the step that led to them
+  std::chrono::steady_clock::time_point time;
+  double step = 0.0;
+
+  /* Fraction of the step by which the state shown at time now is past the
+   * previous positions, where the shown state lags one step behind the
+   * simulation so that it can be interpolated. */
+  float alpha(std::chrono::steady_clock::time_point now) const;
+
+  /* Position of body i blended between the two states by alpha. */
+  glm::vec3 position(size_t i, float alpha) const {
+    return glm::mix(previous[i], current[i], alpha);
+  }
+};
+
+/* Simulates bodies on a thread of its own, in fixed steps in real time, and
+ * publishes their positions after every batch of steps through a triple
+ * buffer. The render thread takes the newest positions without ever waiting
+ * for a step to finish, and a slow frame on either thread does not delay the
+ * other. */
+class physics_thread {
+ public:
+  using step_function = std::function<void(particle_arrays&, float)>;
+
+  /* Starts stepping the bodies with step_fn every step seconds, catching up at
+   * most max_substeps steps at a time. The initial positions are published
+   * before the thread starts. */
+  physics_thread(particle_arrays bodies,
+                 double step,
+                 int max_substeps,
+                 step_function step_fn);
+
+  /* Stops the thread. */
+  ~physics_thread();
+
+  physics_thread(const physics_thread&) = delete;
+  physics_thread& operator=(const physics_thread&) = delete;
+
+  /* Newest published positions. Must only be called from one thread, and the
+   * result stays valid until the next call. */
+  const body_transforms& latest() { return m_transforms.acquire(); }
+
+  /* Stops stepping and waits for the thread to finish. */
+  void stop();
+
+  /* Steps taken and dropped; only valid after stop. */
+  size_t steps() const { return m_stepper.steps(); }
+  size_t dropped_steps() const { return m_stepper.dropped_steps(); }
+
+ private:
+  void run();
+
+  /* Copies the positions to the back slot and publishes it. */
+  void publish(std::chrono::steady_clock::time_point time);
+
+  particle_arrays m_bodies;
+  fixed_timestep m_stepper;
+  step_function m_step_fn;
+
+  triple_buffer<body_transforms> m_transforms;
+
+  std::atomic<bool> m_running{true};
+  std::thread m_thread;
+};
+
+}  // namespace physics::dynamics
+
+#endif  // PHYSICS_THREAD_HPP
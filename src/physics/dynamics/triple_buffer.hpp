@@ -0,0 +1,64 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace physics::dynamics {
+
+/* Hands values from one writer thread to one reader thread without locks or
+ * waiting. Of the three slots, the writer owns one it fills, the reader owns
+ * one it reads, and the third holds the last published value. Publishing and
+ * acquiring exchange the owned slot with the middle one in a single atomic
+ * operation, so neither side ever blocks the other, and the reader always
+ * gets the newest complete value; values published in between are skipped.
+ *
+ *   writer:                          reader:
+ *     fill(buffer.back());             const T& value = buffer.acquire();
+ *     buffer.publish();
+ */
+template <class T>
+class triple_buffer {
+ public:
+  triple_buffer() = default;
+
+  triple_buffer(const triple_buffer&) = delete;
+  triple_buffer& operator=(const triple_buffer&) = delete;
+
+  /* Slot the writer fills before publishing it. Its previous contents are
+   * those of an older value, which lets the writer reuse their storage. */
+  T& back() { return m_slots[m_back]; }
+
+  /* Makes the back slot the newest value and gives the writer a new one. */
+  void publish() {
+    const uint8_t old =
+        m_middle.exchange(uint8_t(m_back | k_fresh), std::memory_order_acq_rel);
+    m_back = old & k_index;
+  }
+
+  /* Takes the newest published value, if there is one the reader has not
+   * seen, and returns the reader's slot. The slot stays valid and unchanged
+   * until the next call. */
+  const T& acquire() {
+    if (m_middle.load(std::memory_order_relaxed) & k_fresh) {
+      m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & k_index;
+    }
+    return m_slots[m_front];
+  }
+
+ private:
+  static constexpr uint8_t k_index = 3;
+  static constexpr uint8_t k_fresh = 4;
+
+  std::array<T, 3> m_slots;
+
+  // each index is written by one thread only, kept on separate cache lines
+  alignas(64) std::atomic<uint8_t> m_middle{1};
+  alignas(64) uint8_t m_back = 0;
+  alignas(64) uint8_t m_front = 2;
+};
+
+}  // namespace physics::dynamics
+
+#endif  // TRIPLE_BUFFER_HPP
@@ -0,0 +1,89 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+namespace physics::utilities {
+
+worker_pool::worker_pool(unsigned num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  // worker i runs task i, the calling thread task 0
+  m_workers.reserve(num_threads - 1);
+  for (unsigned i = 1; i < num_threads; ++i) {
+    m_workers.emplace_back(&worker_pool::work, this, size_t(i));
+  }
+}
+
+worker_pool::~worker_pool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_start.notify_all();
+
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+void worker_pool::run(size_t n_tasks, const std::function<void(size_t)>& task) {
+  n_tasks = std::min<size_t>(n_tasks, size());
+  if (n_tasks == 0) {
+    return;
+  }
+
+  if (n_tasks > 1) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_task = &task;
+      m_n_tasks = n_tasks;
+      m_remaining = n_tasks - 1;
+      ++m_generation;
+    }
+    m_start.notify_all();
+  }
+
+  task(0);
+
+  if (n_tasks > 1) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_remaining == 0; });
+    m_task = nullptr;
+  }
+}
+
+void worker_pool::work(size_t index) {
+  size_t generation = 0;
+
+  for (;;) {
+    const std::function<void(size_t)>* task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start.wait(lock, [&] { return m_stopping || m_generation != generation; });
+      if (m_stopping) {
+        return;
+      }
+
+      generation = m_generation;
+      if (index >= m_n_tasks) {
+        continue;
+      }
+      task = m_task;
+    }
+
+    (*task)(index);
+
+    bool last;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      last = --m_remaining == 0;
+    }
+    if (last) {
+      m_done.notify_one();
+    }
+  }
+}
+
+}  // namespace physics::utilities
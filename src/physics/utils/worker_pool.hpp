@@ -0,0 +1,55 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace physics::utilities {
+
+/* Threads that are started once and then run the tasks of every parallel
+ * loop, so that loops run several times per step do not pay for starting and
+ * joining threads. The calling thread takes part in every loop. */
+class worker_pool {
+ public:
+  /* Runs loops on num_threads threads, including the calling one, or one per
+   * core if 0. */
+  explicit worker_pool(unsigned num_threads = 0);
+
+  /* Stops and joins the workers. */
+  ~worker_pool();
+
+  worker_pool(const worker_pool&) = delete;
+  worker_pool& operator=(const worker_pool&) = delete;
+
+  /* Number of threads, including the calling one. */
+  unsigned size() const { return unsigned(m_workers.size()) + 1; }
+
+  /* Calls task(i) for every i in [0, n_tasks), at most size(), one per
+   * thread, and returns when all calls have returned. Task 0 runs on the
+   * calling thread. */
+  void run(size_t n_tasks, const std::function<void(size_t)>& task);
+
+ private:
+  void work(size_t index);
+
+  std::vector<std::thread> m_workers;
+
+  std::mutex m_mutex;
+  std::condition_variable m_start;
+  std::condition_variable m_done;
+
+  // the current loop, changed by run under the mutex
+  const std::function<void(size_t)>* m_task = nullptr;
+  size_t m_n_tasks = 0;
+  size_t m_generation = 0;
+  size_t m_remaining = 0;
+  bool m_stopping = false;
+};
+
+}  // namespace physics::utilities
+
+#endif  // WORKER_POOL_HPP
@@ -0,0 +1,140 @@
+#include <collision/spatial_grid.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace collision = physics::collision;
+
+using index_pairs = std::vector<std::pair<uint32_t, uint32_t>>;
+
+static int s_failures = 0;
+
+static void check(bool condition, const char* what) {
+  if (!condition) {
+    fprintf(stderr, "FAILED: %s\n", what);
+    ++s_failures;
+  }
+}
+
+struct particles {
+  std::vector<float> x, y, z;
+
+  void add(float px, float py, float pz) {
+    x.push_back(px);
+    y.push_back(py);
+    z.push_back(pz);
+  }
+
+  size_t size() const { return x.size(); }
+};
+
+/* n particles spread uniformly over a cube, about 8 per cell of size 1. */
+static particles random_particles(size_t n, unsigned seed) {
+  std::mt19937 rng(seed);
+  const float side = std::cbrt(n / 8.f);
+  std::uniform_real_distribution<float> coord(-0.5f * side, 0.5f * side);
+
+  particles ps;
+  for (size_t i = 0; i < n; ++i) {
+    ps.add(coord(rng), coord(rng), coord(rng));
+  }
+  return ps;
+}
+
+/* Pairs of a find_pairs by original index, lower index first, sorted. */
+static index_pairs find_pairs(collision::spatial_grid& grid,
+                              const particles& ps,
+                              float distance) {
+  grid.build(ps.x.data(), ps.y.data(), ps.z.data(), ps.size());
+
+  std::vector<collision::particle_pair> pairs;
+  grid.find_pairs(distance, pairs);
+
+  index_pairs found;
+  for (const auto pair : pairs) {
+    const uint32_t a = grid.order()[pair.first];
+    const uint32_t b = grid.order()[pair.second];
+    found.push_back(std::minmax(a, b));
+  }
+  std::sort(found.begin(), found.end());
+  return found;
+}
+
+static index_pairs brute_force_pairs(const particles& ps, float distance) {
+  index_pairs found;
+  for (uint32_t a = 0; a < ps.size(); ++a) {
+    for (uint32_t b = a + 1; b < ps.size(); ++b) {
+      const float dx = ps.x[b] - ps.x[a];
+      const float dy = ps.y[b] - ps.y[a];
+      const float dz = ps.z[b] - ps.z[a];
+      if (dx * dx + dy * dy + dz * dz <= distance * distance) {
+        found.push_back({a, b});
+      }
+    }
+  }
+  return found;
+}
+
+/* The grid finds the same pairs as testing every pair, on one thread and on
+ * several, including particles too far away for their cell to fit in an
+ * int32_t. */
+static void test_against_brute_force() {
+  particles ps = random_particles(3000, 1);
+  ps.add(1e30f, 0.f, 0.f);
+  ps.add(1e30f, 0.f, 0.f);
+  ps.add(-1e30f, -1e30f, -1e30f);
+
+  const index_pairs expected = brute_force_pairs(ps, 1.f);
+  check(!expected.empty(), "particles have pairs");
+
+  collision::spatial_grid single(1.f, 1);
+  check(find_pairs(single, ps, 1.f) == expected, "one thread finds all pairs");
+
+  collision::spatial_grid parallel(1.f, 8);
+  check(find_pairs(parallel, ps, 1.f) == expected, "8 threads find all pairs");
+}
+
+/* The cell order and the pairs do not depend on the number of threads, with
+ * enough particles for every thread to take part. */
+static void test_thread_counts() {
+  const particles ps = random_particles(200000, 2);
+
+  collision::spatial_grid single(1.f, 1);
+  collision::spatial_grid parallel(1.f, 8);
+  std::vector<collision::particle_pair> single_pairs;
+  std::vector<collision::particle_pair> parallel_pairs;
+
+  // the second build reuses the grid's buffers
+  for (int build = 0; build < 2; ++build) {
+    single.build(ps.x.data(), ps.y.data(), ps.z.data(), ps.size());
+    parallel.build(ps.x.data(), ps.y.data(), ps.z.data(), ps.size());
+    check(single.order() == parallel.order(), "cell order is the same");
+
+    single.find_pairs(1.f, single_pairs);
+    parallel.find_pairs(1.f, parallel_pairs);
+    check(single_pairs.size() == parallel_pairs.size() &&
+              std::equal(single_pairs.begin(), single_pairs.end(),
+                         parallel_pairs.begin(),
+                         [](const auto& a, const auto& b) {
+                           return a.first == b.first && a.second == b.second;
+                         }),
+          "pairs are the same");
+  }
+}
+
+int main() {
+  test_against_brute_force();
+  test_thread_counts();
+
+  if (s_failures > 0) {
+    fprintf(stderr, "%d checks failed\n", s_failures);
+    return EXIT_FAILURE;
+  }
+  printf("All checks passed\n");
+  return EXIT_SUCCESS;
+}
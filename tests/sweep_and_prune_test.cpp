@@ -0,0 +1,136 @@
+#include <collision/sweep_and_prune.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace collision = physics::collision;
+
+using pair_set = std::set<std::pair<uint32_t, uint32_t>>;
+
+static int s_failures = 0;
+
+static void check(bool condition, const char* what) {
+  if (!condition) {
+    fprintf(stderr, "FAILED: %s\n", what);
+    ++s_failures;
+  }
+}
+
+static collision::aabb unit_box(const glm::vec3& min) {
+  return {min, min + glm::vec3(1.f)};
+}
+
+/* Applies the events of the last sweep to pairs, failing on events that do
+ * not match it. */
+static void apply_events(const collision::sweep_and_prune& sap, pair_set& pairs) {
+  for (const auto pair : sap.added()) {
+    check(pairs.insert({pair.first, pair.second}).second, "added pair is new");
+  }
+  for (const auto pair : sap.removed()) {
+    check(pairs.erase({pair.first, pair.second}) == 1, "removed pair is known");
+  }
+}
+
+/* Removing both boxes of an overlapping pair in one step reports the pair. */
+static void test_remove_overlapping_boxes() {
+  collision::sweep_and_prune sap;
+  const uint32_t a = sap.add(unit_box(glm::vec3(0.f)));
+  const uint32_t b = sap.add(unit_box(glm::vec3(0.5f)));
+  sap.sweep();
+  check(sap.added().size() == 1 && sap.num_pairs() == 1, "overlapping boxes pair up");
+
+  sap.remove(a);
+  sap.remove(b);
+  sap.sweep();
+  check(sap.removed().size() == 1, "pair of two removed boxes is removed");
+  check(sap.num_pairs() == 0, "no pairs are left");
+  check(!sap.overlapping(a, b), "removed boxes do not overlap");
+
+  // the recycled handles pair up again
+  const uint32_t c = sap.add(unit_box(glm::vec3(0.f)));
+  const uint32_t d = sap.add(unit_box(glm::vec3(0.5f)));
+  sap.sweep();
+  check(sap.added().size() == 1 && sap.overlapping(c, d), "recycled handles pair up");
+}
+
+/* Random moving boxes, with several removals and additions per step, match a
+ * brute force search. */
+static void test_against_brute_force() {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> position(0.f, 10.f);
+  std::uniform_real_distribution<float> motion(-0.1f, 0.1f);
+
+  collision::sweep_and_prune sap;
+  std::vector<collision::aabb> boxes;
+  std::vector<uint32_t> handles;
+  pair_set pairs;
+
+  for (int step = 0; step < 200; ++step) {
+    for (size_t i = 0; i < boxes.size(); ++i) {
+      const glm::vec3 delta(motion(rng), motion(rng), motion(rng));
+      boxes[i] = {boxes[i].min + delta, boxes[i].max + delta};
+      sap.update(handles[i], boxes[i]);
+    }
+
+    for (int k = 0; k < 3 && !boxes.empty(); ++k) {
+      const size_t i = rng() % boxes.size();
+      sap.remove(handles[i]);
+      boxes.erase(boxes.begin() + i);
+      handles.erase(handles.begin() + i);
+    }
+
+    // many boxes at once on the first step, which sorts from scratch
+    for (int k = 0; k < (step == 0 ? 300 : 3); ++k) {
+      boxes.push_back(unit_box(glm::vec3(position(rng), position(rng), position(rng))));
+      handles.push_back(sap.add(boxes.back()));
+    }
+
+    sap.sweep();
+    apply_events(sap, pairs);
+
+    pair_set expected;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+      for (size_t j = i + 1; j < boxes.size(); ++j) {
+        const auto& a = boxes[i];
+        const auto& b = boxes[j];
+        if (a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y &&
+            b.min.y <= a.max.y && a.min.z <= b.max.z && b.min.z <= a.max.z) {
+          expected.insert(std::minmax(handles[i], handles[j]));
+        }
+      }
+    }
+
+    check(pairs == expected, "events match brute force");
+    check(sap.num_pairs() == expected.size(), "pair count matches brute force");
+  }
+}
+
+/* A stack of touching boxes is rebuilt along its long axis. */
+static void test_stack() {
+  constexpr int n = 10000;
+
+  collision::sweep_and_prune sap;
+  for (int i = 0; i < n; ++i) {
+    sap.add(unit_box(glm::vec3(0.f, float(i), 0.f)));
+  }
+  sap.sweep();
+  check(sap.num_pairs() == n - 1, "stacked boxes touch their neighbors");
+}
+
+int main() {
+  test_remove_overlapping_boxes();
+  test_against_brute_force();
+  test_stack();
+
+  if (s_failures > 0) {
+    fprintf(stderr, "%d checks failed\n", s_failures);
+    return EXIT_FAILURE;
+  }
+  printf("All checks passed\n");
+  return EXIT_SUCCESS;
+}